@@ -0,0 +1,452 @@
+//
+// Created on 18/10/26.
+//
+// Measures mempool refresh and mempool rendering at scale
+// without a live node. For each pool size, a temporary lmdb
+// is made and its txpool is filled with synthetic txs
+// of different input/output counts and types (v1, CLSAG
+// with bulletproofs, CLSAG with bulletproofs plus).
+//
+// Reported for each pool size:
+//  - full refresh, i.e., MempoolStatus::read_mempool with all txs new,
+//  - refresh when nothing changed in the txpool,
+//  - incremental refresh after 1% of txs arrive and 1% leave,
+//    in which only these txs are parsed and merged into
+//    the previous snapshot,
+//  - memory of the snapshot columns/indices and rss growth,
+//  - cold and memoized render of the mempool page and /api/mempool.
+//
+// Must be run from the folder with templates/, i.e., the build folder:
+//
+//   ./bench/mempool_bench 1000,10000,50000
+//
+// usage: mempool_bench [pool_sizes] [max_full_txs_size_MB] [tmp_folder]
+//
+
+#define CROW_MAIN
+
+#include "../src/page.h"
+
+#include "synthetic_txs.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+using namespace std;
+using namespace xmreg;
+
+namespace
+{
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename T>
+uint64_t
+elapsed_us(T const& start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            bench_clock::now() - start).count();
+}
+
+// adds no_of_txs synthetic txs to the txpool of the lmdb.
+// hashes of the added txs are appended to tx_hashes.
+bool
+add_synthetic_txs(Blockchain* core_storage, std::mt19937_64& rng,
+                  size_t no_of_txs, vector<crypto::hash>& tx_hashes)
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+
+    // lmdb write txs in batches, as a single
+    // write tx for each mempool tx is very slow
+    constexpr size_t batch_size {1000};
+
+    for (size_t batch_start = 0; batch_start < no_of_txs;
+         batch_start += batch_size)
+    {
+        if (!db.block_wtxn_start())
+        {
+            cerr << "Cant start lmdb write transaction" << endl;
+            return false;
+        }
+
+        try
+        {
+            size_t batch_end = std::min(no_of_txs, batch_start + batch_size);
+
+            for (size_t i = batch_start; i < batch_end; ++i)
+            {
+                uint8_t rct_type;
+                size_t no_inputs, no_outputs;
+
+                random_tx_shape(rng, rct_type, no_inputs, no_outputs);
+
+                uint64_t fee {0};
+
+                transaction tx = make_synthetic_tx(
+                        rng, rct_type, no_inputs, no_outputs, fee);
+
+                cryptonote::blobdata tx_blob = tx_to_blob(tx);
+
+                crypto::hash tx_hash = get_transaction_hash(tx);
+
+                txpool_tx_meta_t meta;
+                memset(&meta, 0, sizeof(meta));
+
+                meta.weight       = get_transaction_weight(tx, tx_blob.size());
+                meta.fee          = fee;
+                meta.receive_time = now - rng() % (24 * 3600);
+                meta.relayed      = 1;
+
+                core_storage->add_txpool_tx(tx_hash, tx_blob, meta);
+
+                tx_hashes.push_back(tx_hash);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant add synthetic txs to txpool: " << e.what() << endl;
+            db.block_wtxn_abort();
+            return false;
+        }
+
+        db.block_wtxn_stop();
+    }
+
+    return true;
+}
+
+bool
+remove_txs(Blockchain* core_storage, vector<crypto::hash> const& tx_hashes)
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    if (!db.block_wtxn_start())
+    {
+        cerr << "Cant start lmdb write transaction" << endl;
+        return false;
+    }
+
+    try
+    {
+        for (crypto::hash const& tx_hash: tx_hashes)
+            db.remove_txpool_tx(tx_hash);
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant remove txs from txpool: " << e.what() << endl;
+        db.block_wtxn_abort();
+        return false;
+    }
+
+    db.block_wtxn_stop();
+
+    return true;
+}
+
+template <typename T>
+uint64_t
+vector_bytes(vector<T> const& v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+template <typename K, typename V>
+uint64_t
+map_bytes(unordered_map<K, V> const& m)
+{
+    // node with the value and pointer to the next one,
+    // and the bucket array
+    return m.size() * (sizeof(pair<const K, V>) + sizeof(void*))
+           + m.bucket_count() * sizeof(void*);
+}
+
+// memory of the columns and indices of the snapshot.
+// It does not include parsed txs of full txs, which are shared
+// between snapshots.
+uint64_t
+snapshot_bytes(MempoolStatus::mempool_snapshot const& snapshot)
+{
+    return sizeof(snapshot)
+           + vector_bytes(snapshot.tx_hashes)
+           + vector_bytes(snapshot.receive_times)
+           + vector_bytes(snapshot.fees)
+           + vector_bytes(snapshot.blob_sizes)
+           + vector_bytes(snapshot.weights)
+           + vector_bytes(snapshot.sum_inputs)
+           + vector_bytes(snapshot.sum_outputs)
+           + vector_bytes(snapshot.no_inputs)
+           + vector_bytes(snapshot.no_outputs)
+           + vector_bytes(snapshot.num_nonrct_inputs)
+           + vector_bytes(snapshot.mixin_nos)
+           + vector_bytes(snapshot.versions)
+           + vector_bytes(snapshot.rct_types)
+           + vector_bytes(snapshot.full_txs)
+           + snapshot.full_txs.size() * sizeof(MempoolStatus::mempool_full_tx)
+           + std::accumulate(snapshot.full_txs.begin(), snapshot.full_txs.end(),
+                             uint64_t {0},
+                             [](uint64_t sum, MempoolStatus::mempool_full_tx_ptr const& full_tx)
+                             {
+                                 return sum + full_tx->get_extra().capacity();
+                             })
+           + map_bytes(snapshot.rows_by_hash)
+           + map_bytes(snapshot.rows_by_key_image);
+}
+
+// resident set size of the process in kB. Only on linux,
+// elsewhere it is always 0.
+uint64_t
+rss_kB()
+{
+    std::ifstream status_file {"/proc/self/status"};
+
+    string line;
+
+    while (std::getline(status_file, line))
+    {
+        if (boost::starts_with(line, "VmRSS:"))
+        {
+            std::istringstream iss {line.substr(6)};
+
+            uint64_t rss {0};
+            iss >> rss;
+
+            return rss;
+        }
+    }
+
+    return 0;
+}
+
+void
+reset_mempool_snapshot()
+{
+    std::lock_guard<std::mutex> lck (MempoolStatus::mempool_mutx);
+
+    MempoolStatus::current_snapshot
+            = std::make_shared<MempoolStatus::mempool_snapshot>();
+}
+
+bool
+run_bench(size_t pool_size, boost::filesystem::path const& tmp_folder,
+          network_type nettype)
+{
+    boost::system::error_code ec;
+
+    boost::filesystem::path db_folder = tmp_folder
+            / ("xmrblocks_mempool_bench_" + std::to_string(pool_size));
+
+    boost::filesystem::remove_all(db_folder, ec);
+    boost::filesystem::create_directories(db_folder, ec);
+
+    bool result {false};
+
+    {
+        MicroCore mcore;
+
+        if (!mcore.init(db_folder.string(), nettype, false))
+        {
+            cerr << "Cant make lmdb in " << db_folder << endl;
+            return false;
+        }
+
+        Blockchain* core_storage = &mcore.get_core();
+
+        std::mt19937_64 rng {pool_size};
+
+        vector<crypto::hash> tx_hashes;
+        tx_hashes.reserve(pool_size + pool_size / 100 + 1);
+
+        if (!add_synthetic_txs(core_storage, rng, pool_size, tx_hashes))
+            return false;
+
+        MempoolStatus::set_blockchain_variables(&mcore, core_storage);
+
+        reset_mempool_snapshot();
+
+        xmreg::page xmrblocks(&mcore, core_storage,
+                              "http://127.0.0.1:18081", nettype,
+                              false, false, false, false, false, false,
+                              false, false, false, 25, 5, "", "", "",
+                              rpccalls::login_opt {});
+
+        // full refresh, all txs are new
+        uint64_t rss_before = rss_kB();
+
+        auto start = bench_clock::now();
+
+        if (!MempoolStatus::read_mempool())
+            return false;
+
+        uint64_t full_refresh_us = elapsed_us(start);
+
+        uint64_t rss_after = rss_kB();
+
+        uint64_t rss_growth = rss_after > rss_before
+                              ? rss_after - rss_before : 0;
+
+        auto snapshot = MempoolStatus::get_mempool_snapshot();
+
+        uint64_t columns_kB = snapshot_bytes(*snapshot) / 1024;
+
+        size_t loaded_full_txs = std::count_if(
+                snapshot->full_txs.begin(), snapshot->full_txs.end(),
+                [](MempoolStatus::mempool_full_tx_ptr const& full_tx)
+                {
+                    return full_tx->is_loaded();
+                });
+
+        // renders of the first snapshot. First ones are cold,
+        // second ones come from snapshot's memo.
+        start = bench_clock::now();
+        string mempool_page = xmrblocks.mempool(true);
+        uint64_t page_cold_us = elapsed_us(start);
+
+        start = bench_clock::now();
+        xmrblocks.mempool(true);
+        uint64_t page_memo_us = elapsed_us(start);
+
+        start = bench_clock::now();
+        xmrblocks.mempool(false, 25);
+        uint64_t front_cold_us = elapsed_us(start);
+
+        start = bench_clock::now();
+        string json_first_page = xmrblocks.json_mempool_serialized("0", "100");
+        uint64_t json_cold_us = elapsed_us(start);
+
+        start = bench_clock::now();
+        xmrblocks.json_mempool_serialized("0", "100");
+        uint64_t json_memo_us = elapsed_us(start);
+
+        // the oldest txs have dropped full txs, so they
+        // are parsed again from the txpool
+        uint64_t last_page = pool_size > 100 ? (pool_size - 1) / 100 : 0;
+
+        start = bench_clock::now();
+        xmrblocks.json_mempool_serialized(std::to_string(last_page), "100");
+        uint64_t json_last_page_us = elapsed_us(start);
+
+        // refresh with the same txpool, which keeps the previous snapshot
+        start = bench_clock::now();
+
+        if (!MempoolStatus::read_mempool())
+            return false;
+
+        uint64_t unchanged_refresh_us = elapsed_us(start);
+
+        // incremental refresh: 1% of txs leave and 1% arrive
+        size_t no_of_changed = std::max<size_t>(1, pool_size / 100);
+
+        vector<crypto::hash> leaving_txs(tx_hashes.begin(),
+                                         tx_hashes.begin() + no_of_changed);
+
+        if (!remove_txs(core_storage, leaving_txs)
+                || !add_synthetic_txs(core_storage, rng,
+                                      no_of_changed, tx_hashes))
+        {
+            return false;
+        }
+
+        start = bench_clock::now();
+
+        if (!MempoolStatus::read_mempool())
+            return false;
+
+        uint64_t incremental_refresh_us = elapsed_us(start);
+
+        cout << "\npool size: " << pool_size
+             << " txs (mempool page " << mempool_page.size() / 1024
+             << " kB, api first page " << json_first_page.size() / 1024
+             << " kB)\n"
+             << "  full refresh          : " << full_refresh_us << " us\n"
+             << "  unchanged refresh     : " << unchanged_refresh_us << " us\n"
+             << "  incremental refresh   : " << incremental_refresh_us
+             << " us (" << no_of_changed << " txs in, "
+             << no_of_changed << " out)\n"
+             << "  snapshot columns      : " << columns_kB << " kB\n"
+             << "  loaded full txs       : " << loaded_full_txs
+             << " of " << snapshot->size() << "\n"
+             << "  rss growth            : " << rss_growth << " kB\n"
+             << "  mempool page cold     : " << page_cold_us << " us\n"
+             << "  mempool page memo     : " << page_memo_us << " us\n"
+             << "  front page mempool    : " << front_cold_us << " us\n"
+             << "  api/mempool cold      : " << json_cold_us << " us\n"
+             << "  api/mempool memo      : " << json_memo_us << " us\n"
+             << "  api/mempool last page : " << json_last_page_us << " us"
+             << endl;
+
+        result = true;
+    }
+
+    boost::filesystem::remove_all(db_folder, ec);
+
+    return result;
+}
+
+}
+
+int
+main(int ac, const char* av[])
+{
+    string pool_sizes_str {"1000,10000,50000"};
+
+    boost::filesystem::path tmp_folder
+            = boost::filesystem::temp_directory_path();
+
+    vector<size_t> pool_sizes;
+
+    try
+    {
+        if (ac > 1)
+            pool_sizes_str = av[1];
+
+        if (ac > 2)
+            MempoolStatus::max_full_txs_size
+                    = boost::lexical_cast<uint64_t>(av[2]) * 1024 * 1024;
+
+        if (ac > 3)
+            tmp_folder = av[3];
+
+        vector<string> size_strs;
+        boost::split(size_strs, pool_sizes_str, boost::is_any_of(","));
+
+        for (string const& size_str: size_strs)
+            pool_sizes.push_back(boost::lexical_cast<size_t>(size_str));
+    }
+    catch (boost::bad_lexical_cast const& e)
+    {
+        cerr << "usage: " << av[0]
+             << " [pool_sizes] [max_full_txs_size_MB] [tmp_folder]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::exists(TMPL_MEMPOOL))
+    {
+        cerr << "Cant find " << TMPL_MEMPOOL
+             << ". Run the benchmark from the build folder." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // the same as default --mempool-max-full-txs-size unless given
+    cout << "max full txs size: "
+         << MempoolStatus::max_full_txs_size / 1024 / 1024 << " MB" << endl;
+
+    for (size_t pool_size: pool_sizes)
+    {
+        if (!run_bench(pool_size, tmp_folder, network_type::MAINNET))
+        {
+            cerr << "Benchmark for " << pool_size << " txs failed" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
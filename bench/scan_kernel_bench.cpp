@@ -0,0 +1,150 @@
+//
+// Created on 18/10/26.
+//
+// Compares batched ScanKernel against the per-output
+// generate_key_derivation/derive_public_key path used
+// previously in page::find_our_outputs.
+//
+// usage: scan_kernel_bench [no_of_txs] [outputs_per_tx]
+//
+
+#include "../src/ScanKernel.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+using namespace xmreg;
+
+int
+main(int ac, const char* av[])
+{
+    size_t no_of_txs      {5000};
+    size_t outputs_per_tx {2};
+
+    try
+    {
+        if (ac > 1)
+            no_of_txs = boost::lexical_cast<size_t>(av[1]);
+
+        if (ac > 2)
+            outputs_per_tx = boost::lexical_cast<size_t>(av[2]);
+    }
+    catch (boost::bad_lexical_cast const& e)
+    {
+        cerr << "usage: " << av[0] << " [no_of_txs] [outputs_per_tx]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // keys of the address that we scan for
+    public_key spend_public_key;
+    secret_key spend_secret_key;
+
+    public_key view_public_key;
+    secret_key view_secret_key;
+
+    generate_keys(spend_public_key, spend_secret_key);
+    generate_keys(view_public_key, view_secret_key);
+
+    // random tx public keys
+    vector<public_key> tx_pub_keys(no_of_txs);
+
+    for (public_key& tx_pub_key: tx_pub_keys)
+    {
+        secret_key tx_secret_key;
+        generate_keys(tx_pub_key, tx_secret_key);
+    }
+
+    // per-output path
+    auto start = std::chrono::steady_clock::now();
+
+    vector<public_key> expected_keys;
+    expected_keys.reserve(no_of_txs * outputs_per_tx);
+
+    for (public_key const& tx_pub_key: tx_pub_keys)
+    {
+        key_derivation derivation;
+
+        if (!generate_key_derivation(tx_pub_key, view_secret_key, derivation))
+        {
+            cerr << "generate_key_derivation failed" << endl;
+            return EXIT_FAILURE;
+        }
+
+        for (size_t output_idx = 0; output_idx < outputs_per_tx; ++output_idx)
+        {
+            public_key derived_key;
+
+            derive_public_key(derivation, output_idx,
+                              spend_public_key, derived_key);
+
+            expected_keys.push_back(derived_key);
+        }
+    }
+
+    auto per_output_duration = std::chrono::duration_cast<std::chrono::microseconds>
+            (std::chrono::steady_clock::now() - start);
+
+    // batched path
+    start = std::chrono::steady_clock::now();
+
+    ScanKernel scan_kernel {spend_public_key};
+
+    vector<key_derivation> derivations;
+
+    if (!ScanKernel::generate_key_derivations(
+            tx_pub_keys, view_secret_key, derivations))
+    {
+        cerr << "ScanKernel::generate_key_derivations failed" << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<key_derivation> batch_derivations;
+    vector<uint64_t> batch_output_indices;
+
+    batch_derivations.reserve(no_of_txs * outputs_per_tx);
+    batch_output_indices.reserve(no_of_txs * outputs_per_tx);
+
+    for (key_derivation const& derivation: derivations)
+    {
+        for (size_t output_idx = 0; output_idx < outputs_per_tx; ++output_idx)
+        {
+            batch_derivations.push_back(derivation);
+            batch_output_indices.push_back(output_idx);
+        }
+    }
+
+    vector<public_key> derived_keys;
+
+    if (!scan_kernel.derive_public_keys(batch_derivations,
+                                        batch_output_indices,
+                                        derived_keys))
+    {
+        cerr << "ScanKernel::derive_public_keys failed" << endl;
+        return EXIT_FAILURE;
+    }
+
+    auto batched_duration = std::chrono::duration_cast<std::chrono::microseconds>
+            (std::chrono::steady_clock::now() - start);
+
+    if (derived_keys != expected_keys)
+    {
+        cerr << "Batched results differ from per-output ones!" << endl;
+        return EXIT_FAILURE;
+    }
+
+    double speedup = batched_duration.count() > 0
+                     ? static_cast<double>(per_output_duration.count())
+                       / batched_duration.count()
+                     : 0.0;
+
+    cout << "txs: " << no_of_txs
+         << ", outputs: " << expected_keys.size() << "\n"
+         << "per-output path: " << per_output_duration.count() << " us\n"
+         << "batched kernel : " << batched_duration.count() << " us\n"
+         << "speedup        : " << speedup << "x" << endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,245 @@
+//
+// Created on 18/10/26.
+//
+// Synthetic txs with random keys and proofs, shared by the
+// benchmarks. Their blobs parse as normal txs, but they would
+// not pass any verification.
+//
+
+#ifndef XMRBLOCKS_SYNTHETIC_TXS_H
+#define XMRBLOCKS_SYNTHETIC_TXS_H
+
+#include "../src/MicroCore.h"
+
+#include <random>
+
+namespace xmreg
+{
+
+template <typename POD>
+POD
+random_pod(std::mt19937_64& rng)
+{
+    POD pod;
+
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(&pod);
+
+    for (size_t i = 0; i < sizeof(POD); ++i)
+        bytes[i] = static_cast<unsigned char>(rng());
+
+    return pod;
+}
+
+inline rct::keyV
+random_keys(std::mt19937_64& rng, size_t no_of_keys)
+{
+    rct::keyV keys(no_of_keys);
+
+    for (rct::key& key: keys)
+        key = random_pod<rct::key>(rng);
+
+    return keys;
+}
+
+// number of L and R terms of a range proof for no_outputs
+inline size_t
+range_proof_rounds(size_t no_outputs)
+{
+    size_t padded_outputs {1};
+    size_t rounds {6};  // log2(64) for a single 64 bit amount
+
+    while (padded_outputs < no_outputs)
+    {
+        padded_outputs <<= 1;
+        ++rounds;
+    }
+
+    return rounds;
+}
+
+// Synthetic tx of given type, with random keys and proofs.
+// Its blob parses as a normal tx, but it would
+// not pass any verification.
+inline transaction
+make_synthetic_tx(std::mt19937_64& rng, uint8_t rct_type,
+                  size_t no_inputs, size_t no_outputs, uint64_t& fee)
+{
+    transaction tx;
+
+    tx.version     = rct_type == rct::RCTTypeNull ? 1 : 2;
+    tx.unlock_time = 0;
+
+    size_t ring_size = rct_type == rct::RCTTypeNull ? 1 + rng() % 5 : 16;
+
+    uint64_t sum_inputs {0};
+
+    for (size_t i = 0; i < no_inputs; ++i)
+    {
+        txin_to_key in;
+
+        in.amount = rct_type == rct::RCTTypeNull
+                    ? (1 + rng() % 1000) * 1000000000ull : 0;
+        in.k_image = random_pod<crypto::key_image>(rng);
+
+        for (size_t j = 0; j < ring_size; ++j)
+            in.key_offsets.push_back(1 + rng() % 100000);
+
+        sum_inputs += in.amount;
+
+        tx.vin.push_back(in);
+    }
+
+    fee = (20000 + rng() % 200000) * 1000;
+
+    for (size_t i = 0; i < no_outputs; ++i)
+    {
+        tx_out out;
+
+        if (rct_type == rct::RCTTypeBulletproofPlus)
+        {
+            txout_to_tagged_key tagged_key;
+
+            tagged_key.key = random_pod<crypto::public_key>(rng);
+            tagged_key.view_tag.data = static_cast<char>(rng());
+
+            out.target = tagged_key;
+        }
+        else
+        {
+            out.target = txout_to_key {random_pod<crypto::public_key>(rng)};
+        }
+
+        if (rct_type == rct::RCTTypeNull)
+        {
+            out.amount = i + 1 < no_outputs
+                         ? (sum_inputs - fee) / no_outputs
+                         : sum_inputs - fee
+                           - (sum_inputs - fee) / no_outputs * (no_outputs - 1);
+        }
+
+        tx.vout.push_back(out);
+    }
+
+    add_tx_pub_key_to_extra(tx, random_pod<crypto::public_key>(rng));
+
+    if (rct_type == rct::RCTTypeNull)
+    {
+        tx.signatures.resize(no_inputs);
+
+        for (auto& ring_signatures: tx.signatures)
+        {
+            ring_signatures.resize(ring_size);
+
+            for (crypto::signature& sig: ring_signatures)
+                sig = random_pod<crypto::signature>(rng);
+        }
+
+        return tx;
+    }
+
+    rct::rctSig& rv = tx.rct_signatures;
+
+    rv.type    = rct_type;
+    rv.txnFee  = fee;
+    rv.message = random_pod<rct::key>(rng);
+
+    rv.ecdhInfo.resize(no_outputs);
+    rv.outPk.resize(no_outputs);
+
+    for (size_t i = 0; i < no_outputs; ++i)
+    {
+        rv.ecdhInfo[i].amount = random_pod<rct::key>(rng);
+        rv.outPk[i].mask      = random_pod<rct::key>(rng);
+    }
+
+    size_t rounds = range_proof_rounds(no_outputs);
+
+    if (rct_type == rct::RCTTypeBulletproofPlus)
+    {
+        rct::BulletproofPlus bp;
+
+        bp.A  = random_pod<rct::key>(rng);
+        bp.A1 = random_pod<rct::key>(rng);
+        bp.B  = random_pod<rct::key>(rng);
+        bp.r1 = random_pod<rct::key>(rng);
+        bp.s1 = random_pod<rct::key>(rng);
+        bp.d1 = random_pod<rct::key>(rng);
+        bp.L  = random_keys(rng, rounds);
+        bp.R  = random_keys(rng, rounds);
+
+        rv.p.bulletproofs_plus.push_back(bp);
+    }
+    else
+    {
+        rct::Bulletproof bp;
+
+        bp.A    = random_pod<rct::key>(rng);
+        bp.S    = random_pod<rct::key>(rng);
+        bp.T1   = random_pod<rct::key>(rng);
+        bp.T2   = random_pod<rct::key>(rng);
+        bp.taux = random_pod<rct::key>(rng);
+        bp.mu   = random_pod<rct::key>(rng);
+        bp.L    = random_keys(rng, rounds);
+        bp.R    = random_keys(rng, rounds);
+        bp.a    = random_pod<rct::key>(rng);
+        bp.b    = random_pod<rct::key>(rng);
+        bp.t    = random_pod<rct::key>(rng);
+
+        rv.p.bulletproofs.push_back(bp);
+    }
+
+    rv.p.CLSAGs.resize(no_inputs);
+
+    for (rct::clsag& clsag: rv.p.CLSAGs)
+    {
+        clsag.s  = random_keys(rng, ring_size);
+        clsag.c1 = random_pod<rct::key>(rng);
+        clsag.D  = random_pod<rct::key>(rng);
+    }
+
+    rv.p.pseudoOuts = random_keys(rng, no_inputs);
+
+    return tx;
+}
+
+// Mostly small txs with two outputs, as in a normal
+// mempool, with some consolidations and batched payouts.
+inline void
+random_tx_shape(std::mt19937_64& rng, uint8_t& rct_type,
+                size_t& no_inputs, size_t& no_outputs)
+{
+    uint64_t type_roll = rng() % 100;
+
+    rct_type = type_roll < 2  ? rct::RCTTypeNull
+             : type_roll < 12 ? rct::RCTTypeCLSAG
+                              : rct::RCTTypeBulletproofPlus;
+
+    uint64_t shape_roll = rng() % 100;
+
+    if (shape_roll < 70)
+    {
+        no_inputs  = 1 + rng() % 2;
+        no_outputs = 2;
+    }
+    else if (shape_roll < 90)
+    {
+        no_inputs  = 1 + rng() % 4;
+        no_outputs = 2 + rng() % 3;
+    }
+    else if (shape_roll < 97)
+    {
+        // consolidations
+        no_inputs  = 8 + rng() % 56;
+        no_outputs = 1 + rng() % 2;
+    }
+    else
+    {
+        // batched payouts
+        no_inputs  = 1 + rng() % 8;
+        no_outputs = 8 + rng() % 9;
+    }
+}
+
+}
+
+#endif //XMRBLOCKS_SYNTHETIC_TXS_H
@@ -0,0 +1,776 @@
+//
+// Created on 18/10/26.
+//
+// Micro and macro benchmarks of what the explorer does for
+// most of its pages, on fixture txs in a temporary lmdb:
+//  - get_tx_details, summary_of_in_out_rct, find_our_outputs,
+//    decode_ringct and timestamps_time_scale for all fixture txs,
+//  - rendering of the tx template alone, and the whole /tx page,
+//  - the whole front page, i.e., index2,
+//  - json_transactions, i.e., /api/transactions, and its json dump.
+//
+// Fixture blocks and txs are made from a fixed seed, so each run,
+// and each version of the explorer, gets the same ones. Ring members
+// of their inputs are earlier outputs, and some of their outputs go
+// to a fixture address, so that there is something to decode.
+//
+// Results are json, written to stdout or to results_file, e.g.,
+//
+//   {"benchmarks": {"get_tx_details": {"check": 4390, "median_us": 8312,
+//                   "min_us": 8101, "max_us": 9020, "ops": 1680,
+//                   "per_op_ns": 4947, "runs": 20}, ...},
+//    "commit": "...", "fixture": {"blocks": 100, "txs": 1680, ...}}
+//
+// "check" is a sum of results, e.g., found outputs, which should not
+// change between versions unless their output changes. If results of
+// an earlier run are given as baseline_file, each benchmark also gets
+// its baseline median and "change", e.g., 0.8 for 20% faster.
+//
+// Must be run from the folder with templates/, i.e., the build folder:
+//
+//   ./bench/xmrblocks_bench 20 new.json old.json
+//
+// usage: xmrblocks_bench [runs] [results_file] [baseline_file] [tmp_folder]
+//
+
+#define CROW_MAIN
+
+#include "../src/page.h"
+
+#include "synthetic_txs.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+
+using namespace std;
+using namespace xmreg;
+
+namespace xmreg
+{
+
+// page keeps them private, as pages dont need them from outside
+struct page_bench
+{
+    static tx_details
+    get_tx_details(page& xmrblocks, transaction const& tx,
+                   uint64_t blk_height, uint64_t bc_height)
+    {
+        return xmrblocks.get_tx_details(tx, false, blk_height, bc_height);
+    }
+
+    static bool
+    find_our_outputs(page& xmrblocks,
+                     account_public_address const& address,
+                     secret_key const& prv_view_key,
+                     vector<transaction> const& txs,
+                     json& j_outputs,
+                     string& error_msg)
+    {
+        return xmrblocks.find_our_outputs(address, prv_view_key,
+                                          0, false,
+                                          txs.cbegin(), txs.cend(),
+                                          j_outputs, error_msg);
+    }
+
+    // the same context and partials as in page::show_tx
+    static mstch::map
+    tx_page_context(page& xmrblocks, transaction const& tx)
+    {
+        mstch::map context {
+                {"testnet"          , false},
+                {"stagenet"         , false},
+                {"txs"              , mstch::array{}},
+                {"refresh"          , false},
+                {"tx_hash"          , pod_to_hex(get_transaction_hash(tx))}
+        };
+
+        xmrblocks.add_live_updates(context);
+
+        boost::get<mstch::array>(context["txs"]).push_back(
+                xmrblocks.construct_tx_context(tx));
+
+        xmrblocks.add_css_style(context);
+
+        return context;
+    }
+
+    static string
+    render_tx(page& xmrblocks, mstch::map const& context)
+    {
+        map<string, string> partials {
+                {"tx_details", xmrblocks.template_file["tx_details"]},
+        };
+
+        return mstch::render(xmrblocks.template_file["tx"], context, partials);
+    }
+};
+
+}
+
+namespace
+{
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr uint64_t fixture_seed {20261018};
+
+// blocks after the genesis one
+constexpr size_t no_of_blocks {100};
+
+// blocks before them have only coinbase txs,
+// so that rings have outputs to be made of
+constexpr size_t ring_size {16};
+
+constexpr size_t txs_per_block {20};
+
+template <typename T>
+uint64_t
+elapsed_us(T const& start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            bench_clock::now() - start).count();
+}
+
+struct our_output
+{
+    size_t tx_no;
+    size_t output_idx;
+    key_derivation derivation;
+    uint64_t amount;
+};
+
+struct fixture
+{
+    account_public_address address;
+    secret_key prv_view_key;
+
+    // non-coinbase txs of all blocks, and their block heights
+    vector<transaction> txs;
+    vector<uint64_t> tx_heights;
+
+    vector<our_output> our_outputs;
+
+    vector<uint64_t> blk_timestamps;
+};
+
+// ring members of rct inputs are picked from outputs
+// 0 to no_of_rct_outputs - 1, i.e., of earlier blocks
+void
+set_ring_members(transaction& tx, std::mt19937_64& rng,
+                 uint64_t no_of_rct_outputs)
+{
+    if (tx.version == 1)
+        return;
+
+    for (txin_v& in: tx.vin)
+    {
+        txin_to_key& in_key = boost::get<txin_to_key>(in);
+
+        std::set<uint64_t> members;
+
+        while (members.size() < in_key.key_offsets.size())
+            members.insert(rng() % no_of_rct_outputs);
+
+        in_key.key_offsets = absolute_output_offsets_to_relative(
+                vector<uint64_t>(members.begin(), members.end()));
+    }
+}
+
+// output_idx of rct tx goes to the address, with amount encrypted for
+// it as in real txs. derivation is the one the owner gets with viewkey
+void
+pay_to_address(transaction& tx, size_t output_idx,
+               account_public_address const& address,
+               std::mt19937_64& rng, uint64_t amount,
+               key_derivation& derivation)
+{
+    public_key tx_pub_key;
+    secret_key tx_secret_key;
+
+    crypto::generate_keys(tx_pub_key, tx_secret_key,
+                          random_pod<secret_key>(rng), true);
+
+    generate_key_derivation(address.m_view_public_key,
+                            tx_secret_key, derivation);
+
+    public_key out_key;
+
+    derive_public_key(derivation, output_idx,
+                      address.m_spend_public_key, out_key);
+
+    tx_out& out = tx.vout[output_idx];
+
+    if (out.target.type() == typeid(txout_to_tagged_key))
+    {
+        txout_to_tagged_key tagged_key;
+
+        tagged_key.key = out_key;
+        crypto::derive_view_tag(derivation, output_idx, tagged_key.view_tag);
+
+        out.target = tagged_key;
+    }
+    else
+    {
+        out.target = txout_to_key {out_key};
+    }
+
+    tx.extra.clear();
+    add_tx_pub_key_to_extra(tx, tx_pub_key);
+
+    secret_key scalar;
+    derivation_to_scalar(derivation, output_idx, scalar);
+
+    rct::key shared_secret = rct::sk2rct(scalar);
+    rct::key mask          = rct::genCommitmentMask(shared_secret);
+
+    rct::ecdhTuple ecdh_info;
+
+    ecdh_info.mask   = mask;
+    ecdh_info.amount = rct::d2h(amount);
+
+    rct::ecdhEncode(ecdh_info, shared_secret, true);
+
+    tx.rct_signatures.outPk[output_idx].mask = rct::commit(amount, mask);
+    tx.rct_signatures.ecdhInfo[output_idx]   = ecdh_info;
+}
+
+transaction
+make_coinbase_tx(std::mt19937_64& rng, uint64_t height, uint64_t reward)
+{
+    transaction miner_tx;
+
+    miner_tx.version     = 2;
+    miner_tx.unlock_time = height + CRYPTONOTE_MINED_MONEY_UNLOCK_WINDOW;
+
+    txin_gen in;
+    in.height = height;
+
+    miner_tx.vin.push_back(in);
+
+    txout_to_tagged_key tagged_key;
+
+    tagged_key.key = random_pod<crypto::public_key>(rng);
+    tagged_key.view_tag.data = static_cast<char>(rng());
+
+    tx_out out;
+
+    out.amount = reward;
+    out.target = tagged_key;
+
+    miner_tx.vout.push_back(out);
+
+    add_tx_pub_key_to_extra(miner_tx, random_pod<crypto::public_key>(rng));
+
+    miner_tx.rct_signatures.type = rct::RCTTypeNull;
+
+    return miner_tx;
+}
+
+// adds fixture blocks on top of the genesis one
+bool
+add_fixture_blocks(Blockchain* core_storage, std::mt19937_64& rng,
+                   fixture& f)
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    uint64_t height = db.height();
+
+    uint64_t timestamp = static_cast<uint64_t>(std::time(nullptr))
+                         - no_of_blocks * DIFFICULTY_TARGET_V2;
+
+    difficulty_type cumulative_difficulty
+            = db.get_block_cumulative_difficulty(height - 1);
+
+    uint64_t coins_generated
+            = db.get_block_already_generated_coins(height - 1);
+
+    uint64_t no_of_rct_outputs {0};
+
+    constexpr uint64_t reward {600000000000};
+
+    for (size_t i = 0; i < no_of_blocks; ++i, ++height)
+    {
+        block blk;
+
+        blk.major_version = 16;
+        blk.minor_version = 16;
+        blk.timestamp     = timestamp + i * DIFFICULTY_TARGET_V2;
+        blk.prev_id       = db.top_block_hash();
+        blk.nonce         = static_cast<uint32_t>(rng());
+        blk.miner_tx      = make_coinbase_tx(rng, height, reward);
+
+        vector<pair<transaction, blobdata>> txs;
+
+        uint64_t blk_weight = get_transaction_weight(blk.miner_tx);
+
+        size_t no_of_txs = i < ring_size ? 0 : txs_per_block;
+
+        for (size_t j = 0; j < no_of_txs; ++j)
+        {
+            uint8_t rct_type;
+            size_t no_inputs, no_outputs;
+
+            random_tx_shape(rng, rct_type, no_inputs, no_outputs);
+
+            uint64_t fee {0};
+
+            transaction tx = make_synthetic_tx(
+                    rng, rct_type, no_inputs, no_outputs, fee);
+
+            set_ring_members(tx, rng, no_of_rct_outputs);
+
+            // every fourth rct tx pays to the fixture address
+            if (tx.version > 1 && rng() % 4 == 0)
+            {
+                uint64_t amount = 1000000000 + rng() % 1000000000000;
+
+                key_derivation derivation;
+
+                pay_to_address(tx, 0, f.address, rng, amount, derivation);
+
+                f.our_outputs.push_back({f.txs.size(), 0, derivation, amount});
+            }
+
+            tx.invalidate_hashes();
+
+            cryptonote::blobdata tx_blob = tx_to_blob(tx);
+
+            blk_weight += get_transaction_weight(tx, tx_blob.size());
+
+            blk.tx_hashes.push_back(get_transaction_hash(tx));
+
+            txs.emplace_back(tx, std::move(tx_blob));
+
+            f.txs.push_back(tx);
+            f.tx_heights.push_back(height);
+        }
+
+        cumulative_difficulty += 300000000000;
+        coins_generated       += reward;
+
+        if (!db.block_wtxn_start())
+        {
+            cerr << "Cant start lmdb write transaction" << endl;
+            return false;
+        }
+
+        try
+        {
+            db.add_block(std::make_pair(blk, block_to_blob(blk)),
+                         blk_weight, blk_weight,
+                         cumulative_difficulty, coins_generated, txs);
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant add fixture block " << height
+                 << ": " << e.what() << endl;
+            db.block_wtxn_abort();
+            return false;
+        }
+
+        db.block_wtxn_stop();
+
+        f.blk_timestamps.push_back(blk.timestamp);
+
+        // coinbase output and outputs of rct txs
+        no_of_rct_outputs += 1;
+
+        for (auto const& tx: txs)
+            no_of_rct_outputs += tx.first.version > 1 ? tx.first.vout.size() : 0;
+    }
+
+    return true;
+}
+
+// func is run once to warm up, e.g., lmdb pages,
+// and then runs times. It returns its check value.
+json
+run_bench(size_t runs, uint64_t ops, std::function<uint64_t()> const& func)
+{
+    uint64_t check = func();
+
+    vector<uint64_t> run_us;
+
+    for (size_t i = 0; i < runs; ++i)
+    {
+        auto start = bench_clock::now();
+
+        check = func();
+
+        run_us.push_back(elapsed_us(start));
+    }
+
+    std::sort(run_us.begin(), run_us.end());
+
+    uint64_t median_us = run_us[run_us.size() / 2];
+
+    return json {
+            {"runs"     , runs},
+            {"ops"      , ops},
+            {"check"    , check},
+            {"median_us", median_us},
+            {"min_us"   , run_us.front()},
+            {"max_us"   , run_us.back()},
+            {"per_op_ns", ops > 0 ? median_us * 1000 / ops : 0}};
+}
+
+// most viewed tx pages are of txs with a few inputs,
+// so the one with the most inputs of up to 4 is used
+size_t
+tx_to_show(fixture const& f)
+{
+    size_t tx_no {0};
+
+    for (size_t i = 0; i < f.txs.size(); ++i)
+    {
+        size_t no_inputs = f.txs[i].vin.size();
+
+        if (f.txs[i].version > 1 && no_inputs <= 4
+                && no_inputs > f.txs[tx_no].vin.size())
+        {
+            tx_no = i;
+        }
+    }
+
+    return tx_no;
+}
+
+json
+run_benchmarks(page& xmrblocks, fixture const& f, size_t runs)
+{
+    json j_benchmarks;
+
+    uint64_t bc_height = f.tx_heights.back() + 1;
+
+    j_benchmarks["get_tx_details"] = run_bench(runs, f.txs.size(), [&]()
+    {
+        uint64_t check {0};
+
+        for (size_t i = 0; i < f.txs.size(); ++i)
+        {
+            tx_details txd = page_bench::get_tx_details(
+                    xmrblocks, f.txs[i], f.tx_heights[i], bc_height);
+
+            check += txd.output_pub_keys.size() + txd.input_key_imgs.size();
+        }
+
+        return check;
+    });
+
+    j_benchmarks["summary_of_in_out_rct"] = run_bench(runs, f.txs.size(), [&]()
+    {
+        uint64_t check {0};
+
+        for (transaction const& tx: f.txs)
+        {
+            vector<output_tuple_with_tag> output_pub_keys;
+            vector<txin_to_key> input_key_imgs;
+
+            array<uint64_t, 4> sum_data = summary_of_in_out_rct(
+                    tx, output_pub_keys, input_key_imgs);
+
+            check += sum_data[2] + output_pub_keys.size();
+        }
+
+        return check;
+    });
+
+    j_benchmarks["find_our_outputs"] = run_bench(runs, f.txs.size(), [&]()
+    {
+        json j_outputs = json::array();
+        string error_msg;
+
+        if (!page_bench::find_our_outputs(xmrblocks, f.address,
+                                          f.prv_view_key, f.txs,
+                                          j_outputs, error_msg))
+        {
+            cerr << "find_our_outputs: " << error_msg << endl;
+            return uint64_t {0};
+        }
+
+        return static_cast<uint64_t>(j_outputs.size());
+    });
+
+    j_benchmarks["decode_ringct"] = run_bench(runs, f.our_outputs.size(), [&]()
+    {
+        uint64_t check {0};
+
+        for (our_output const& o: f.our_outputs)
+        {
+            transaction const& tx = f.txs[o.tx_no];
+
+            rct::key mask = tx.rct_signatures.ecdhInfo[o.output_idx].mask;
+            uint64_t amount {0};
+
+            if (decode_ringct(tx.rct_signatures, o.derivation,
+                              o.output_idx, mask, amount)
+                    && amount == o.amount)
+            {
+                ++check;
+            }
+        }
+
+        return check;
+    });
+
+    // timestamps of ring members of each input, as on tx pages
+    vector<vector<uint64_t>> ring_timestamps;
+
+    std::mt19937_64 rng {fixture_seed};
+
+    for (transaction const& tx: f.txs)
+    {
+        for (size_t i = 0; i < tx.vin.size(); ++i)
+        {
+            vector<uint64_t> timestamps;
+
+            for (size_t j = 0; j < ring_size; ++j)
+                timestamps.push_back(f.blk_timestamps[rng() % f.blk_timestamps.size()]);
+
+            ring_timestamps.push_back(timestamps);
+        }
+    }
+
+    j_benchmarks["timestamps_time_scale"] = run_bench(runs, ring_timestamps.size(), [&]()
+    {
+        uint64_t check {0};
+
+        for (vector<uint64_t> const& timestamps: ring_timestamps)
+        {
+            pair<string, double> time_scale = timestamps_time_scale(
+                    timestamps, f.blk_timestamps.back(), 80,
+                    f.blk_timestamps.front());
+
+            check += time_scale.first.size();
+        }
+
+        return check;
+    });
+
+    transaction const& tx = f.txs[tx_to_show(f)];
+
+    mstch::map tx_context = page_bench::tx_page_context(xmrblocks, tx);
+
+    j_benchmarks["render_tx"] = run_bench(runs, 1, [&]()
+    {
+        return static_cast<uint64_t>(
+                page_bench::render_tx(xmrblocks, tx_context).size());
+    });
+
+    string tx_hash_str = pod_to_hex(get_transaction_hash(tx));
+
+    j_benchmarks["show_tx"] = run_bench(runs, 1, [&]()
+    {
+        return static_cast<uint64_t>(xmrblocks.show_tx(tx_hash_str).size());
+    });
+
+    // mempool part of the front page is memoized after
+    // the warm up run, as it is between mempool refreshes
+    j_benchmarks["index2"] = run_bench(runs, 1, [&]()
+    {
+        return static_cast<uint64_t>(xmrblocks.index2().size());
+    });
+
+    j_benchmarks["json_transactions"] = run_bench(runs, 1, [&]()
+    {
+        json j_response = xmrblocks.json_transactions("0", "25");
+
+        return static_cast<uint64_t>(
+                j_response["data"]["blocks"].size());
+    });
+
+    json j_transactions = xmrblocks.json_transactions("0", "25");
+
+    j_benchmarks["json_transactions_dump"] = run_bench(runs, 1, [&]()
+    {
+        return static_cast<uint64_t>(j_transactions.dump().size());
+    });
+
+    return j_benchmarks;
+}
+
+// adds medians of the same benchmarks of an earlier run
+void
+compare_with_baseline(json& j_results, json const& j_baseline)
+{
+    if (!j_baseline.count("benchmarks"))
+        return;
+
+    json const& j_baseline_benchmarks = j_baseline["benchmarks"];
+
+    for (auto it = j_results["benchmarks"].begin();
+         it != j_results["benchmarks"].end(); ++it)
+    {
+        if (!j_baseline_benchmarks.count(it.key()))
+            continue;
+
+        json const& j_old = j_baseline_benchmarks[it.key()];
+
+        uint64_t baseline_median_us = j_old.value("median_us", uint64_t {0});
+
+        (*it)["baseline_median_us"] = baseline_median_us;
+
+        if (baseline_median_us > 0)
+        {
+            (*it)["change"] = static_cast<double>(
+                    (*it)["median_us"].get<uint64_t>()) / baseline_median_us;
+        }
+
+        if (j_old.value("check", uint64_t {0}) != (*it)["check"].get<uint64_t>())
+        {
+            cerr << it.key() << ": check differs from baseline" << endl;
+        }
+    }
+}
+
+}
+
+int
+main(int ac, const char* av[])
+{
+    size_t runs {20};
+
+    string results_file;
+    string baseline_file;
+
+    boost::filesystem::path tmp_folder
+            = boost::filesystem::temp_directory_path();
+
+    try
+    {
+        if (ac > 1)
+            runs = std::max<size_t>(1, boost::lexical_cast<size_t>(av[1]));
+
+        if (ac > 2)
+            results_file = av[2];
+
+        if (ac > 3)
+            baseline_file = av[3];
+
+        if (ac > 4)
+            tmp_folder = av[4];
+    }
+    catch (boost::bad_lexical_cast const& e)
+    {
+        cerr << "usage: " << av[0]
+             << " [runs] [results_file] [baseline_file] [tmp_folder]" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!boost::filesystem::exists(TMPL_TX))
+    {
+        cerr << "Cant find " << TMPL_TX
+             << ". Run the benchmark from the build folder." << endl;
+        return EXIT_FAILURE;
+    }
+
+    json j_baseline;
+
+    if (!baseline_file.empty())
+    {
+        try
+        {
+            j_baseline = json::parse(xmreg::read(baseline_file));
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant read baseline " << baseline_file
+                 << ": " << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    boost::system::error_code ec;
+
+    boost::filesystem::path db_folder = tmp_folder / "xmrblocks_bench";
+
+    boost::filesystem::remove_all(db_folder, ec);
+    boost::filesystem::create_directories(db_folder, ec);
+
+    json j_results;
+
+    {
+        MicroCore mcore;
+
+        if (!mcore.init(db_folder.string(), network_type::MAINNET, false))
+        {
+            cerr << "Cant make lmdb in " << db_folder << endl;
+            return EXIT_FAILURE;
+        }
+
+        Blockchain* core_storage = &mcore.get_core();
+
+        std::mt19937_64 rng {fixture_seed};
+
+        fixture f;
+
+        public_key spend_public_key;
+        secret_key spend_secret_key;
+
+        crypto::generate_keys(spend_public_key, spend_secret_key,
+                              random_pod<secret_key>(rng), true);
+
+        crypto::generate_keys(f.address.m_view_public_key, f.prv_view_key,
+                              random_pod<secret_key>(rng), true);
+
+        f.address.m_spend_public_key = spend_public_key;
+
+        if (!add_fixture_blocks(core_storage, rng, f))
+        {
+            boost::filesystem::remove_all(db_folder, ec);
+            return EXIT_FAILURE;
+        }
+
+        MempoolStatus::set_blockchain_variables(&mcore, core_storage);
+
+        xmreg::page xmrblocks(&mcore, core_storage,
+                              "http://127.0.0.1:18081",
+                              network_type::MAINNET,
+                              false, false, false, false, false, false,
+                              false, false, false, 25, 5, "", "", "",
+                              rpccalls::login_opt {});
+
+        j_results["commit"] = GIT_COMMIT_HASH;
+        j_results["branch"] = GIT_BRANCH_NAME;
+
+        j_results["fixture"] = json {
+                {"seed"       , fixture_seed},
+                {"blocks"     , no_of_blocks},
+                {"txs"        , f.txs.size()},
+                {"our_outputs", f.our_outputs.size()}};
+
+        j_results["benchmarks"] = run_benchmarks(xmrblocks, f, runs);
+    }
+
+    boost::filesystem::remove_all(db_folder, ec);
+
+    if (!j_baseline.is_null())
+        compare_with_baseline(j_results, j_baseline);
+
+    string results = j_results.dump(2);
+
+    if (results_file.empty())
+    {
+        cout << results << endl;
+    }
+    else
+    {
+        std::ofstream out {results_file};
+
+        if (!(out << results << endl))
+        {
+            cerr << "Cant write results to " << results_file << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
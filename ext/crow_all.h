@@ -1105,6 +1105,13 @@ namespace crow
             return socket_.remote_endpoint();
         }
 
+        std::string address()
+        {
+            error_code ec;
+            tcp::endpoint endpoint = socket_.remote_endpoint(ec);
+            return ec ? std::string() : endpoint.address().to_string();
+        }
+
         bool is_open()
         {
             return socket_.is_open();
@@ -1143,6 +1150,80 @@ namespace crow
         tcp::socket socket_;
     };
 
+    using stream_protocol = asio::local::stream_protocol;
+
+    /// A wrapper for the asio::local::stream_protocol::socket, i.e., a unix domain socket
+    struct UnixSocketAdaptor
+    {
+        using context = void;
+        UnixSocketAdaptor(asio::io_context& io_context, context*):
+          socket_(io_context)
+        {}
+
+        asio::io_context& get_io_context()
+        {
+            return GET_IO_CONTEXT(socket_);
+        }
+
+        stream_protocol::socket& raw_socket()
+        {
+            return socket_;
+        }
+
+        stream_protocol::socket& socket()
+        {
+            return socket_;
+        }
+
+        stream_protocol::endpoint remote_endpoint()
+        {
+            return socket_.remote_endpoint();
+        }
+
+        /// Peers of unix domain sockets have no address
+        std::string address()
+        {
+            return std::string();
+        }
+
+        bool is_open()
+        {
+            return socket_.is_open();
+        }
+
+        void close()
+        {
+            error_code ec;
+            socket_.close(ec);
+        }
+
+        void shutdown_readwrite()
+        {
+            error_code ec;
+            socket_.shutdown(asio::socket_base::shutdown_type::shutdown_both, ec);
+        }
+
+        void shutdown_write()
+        {
+            error_code ec;
+            socket_.shutdown(asio::socket_base::shutdown_type::shutdown_send, ec);
+        }
+
+        void shutdown_read()
+        {
+            error_code ec;
+            socket_.shutdown(asio::socket_base::shutdown_type::shutdown_receive, ec);
+        }
+
+        template<typename F>
+        void start(F f)
+        {
+            f(error_code());
+        }
+
+        stream_protocol::socket socket_;
+    };
+
 #ifdef CROW_ENABLE_SSL
     struct SSLAdaptor
     {
@@ -1168,6 +1249,13 @@ namespace crow
             return raw_socket().remote_endpoint();
         }
 
+        std::string address()
+        {
+            error_code ec;
+            tcp::endpoint endpoint = raw_socket().remote_endpoint(ec);
+            return ec ? std::string() : endpoint.address().to_string();
+        }
+
         bool is_open()
         {
             return ssl_socket_ ? raw_socket().is_open() : false;
@@ -9591,7 +9679,7 @@ namespace crow
             req_.middleware_container = static_cast<void*>(middlewares_);
             req_.io_context = &adaptor_.get_io_context();
 
-            req_.remote_ip_address = adaptor_.remote_endpoint().address().to_string();
+            req_.remote_ip_address = adaptor_.address();
 
             add_keep_alive_ = req_.keep_alive;
             close_connection_ = req_.close_connection;
@@ -9623,7 +9711,7 @@ namespace crow
                 }
             }
 
-            CROW_LOG_INFO << "Request: " << utility::lexical_cast<std::string>(adaptor_.remote_endpoint()) << " " << this << " HTTP/" << (char)(req_.http_ver_major + '0') << "." << (char)(req_.http_ver_minor + '0') << ' ' << method_name(req_.method) << " " << req_.url;
+            CROW_LOG_INFO << "Request: " << req_.remote_ip_address << " " << this << " HTTP/" << (char)(req_.http_ver_major + '0') << "." << (char)(req_.http_ver_minor + '0') << ' ' << method_name(req_.method) << " " << req_.url;
 
 
             need_to_call_after_handlers_ = false;
@@ -9662,6 +9750,12 @@ namespace crow
         /// Call the after handle middleware and send the write the response to the connection.
         void complete_request()
         {
+            // when a response is completed asynchronously, i.e., res.end()
+            // is called after the handler returned, complete_request_handler_
+            // holds the last reference to the connection. It is reset in
+            // prepare_buffers(), so keep the connection alive until we finish.
+            auto self = this->shared_from_this();
+
             CROW_LOG_INFO << "Response: " << this << ' ' << req_.raw_url << ' ' << res.code << ' ' << close_connection_;
             res.is_alive_helper_ = nullptr;
 
@@ -10349,7 +10443,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 
             std::string get_remote_ip() override
             {
-                return adaptor_.remote_endpoint().address().to_string();
+                return adaptor_.address();
             }
 
             void set_max_payload_size(uint64_t payload)
@@ -10926,12 +11020,18 @@ namespace crow
 #endif
 
 #include <atomic>
+#include <cerrno>
 #include <chrono>
 #include <cstdint>
 #include <future>
 #include <memory>
+#include <sstream>
+#include <system_error>
 #include <vector>
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 
 
 namespace crow // NOTE: Already documented in "crow/app.h"
@@ -10944,12 +11044,98 @@ namespace crow // NOTE: Already documented in "crow/app.h"
 #endif
     using tcp = asio::ip::tcp;
 
-    template<typename Handler, typename Adaptor = SocketAdaptor, typename... Middlewares>
+    /// Accepts connections on a TCP port
+    struct TCPAcceptor
+    {
+        using endpoint = tcp::endpoint;
+
+        TCPAcceptor(asio::io_context& io_context, const endpoint& ep):
+          acceptor_(io_context, ep)
+        {}
+
+        tcp::acceptor& raw_acceptor()
+        {
+            return acceptor_;
+        }
+
+        uint16_t port() const
+        {
+            return acceptor_.local_endpoint().port();
+        }
+
+        std::string url_display(bool ssl_used) const
+        {
+            std::ostringstream url;
+            url << (ssl_used ? "https://" : "http://")
+                << acceptor_.local_endpoint().address() << ":" << port();
+            return url.str();
+        }
+
+        tcp::acceptor acceptor_;
+    };
+
+    /// Accepts connections on a unix domain socket. A socket left
+    /// at the path, e.g., after a crash, is removed first. Any other
+    /// file there is not touched, and the acceptor throws instead.
+    /// Permissions of the socket are set before it starts listening,
+    /// so that it is never connectable with the umask ones.
+    struct UnixSocketAcceptor
+    {
+        struct endpoint
+        {
+            std::string path;
+            unsigned mode;
+        };
+
+        UnixSocketAcceptor(asio::io_context& io_context, const endpoint& ep):
+          acceptor_(io_context)
+        {
+            struct stat st;
+            if (::lstat(ep.path.c_str(), &st) == 0)
+            {
+                if (!S_ISSOCK(st.st_mode))
+                    throw std::runtime_error("file exists and is not a socket");
+                ::unlink(ep.path.c_str());
+            }
+
+            stream_protocol::endpoint local_ep(ep.path);
+            acceptor_.open(local_ep.protocol());
+            acceptor_.bind(local_ep);
+
+            if (::chmod(ep.path.c_str(), ep.mode) != 0)
+            {
+                int err = errno;
+                ::unlink(ep.path.c_str());
+                throw std::system_error(err, std::generic_category(), "can not set socket permissions");
+            }
+
+            acceptor_.listen();
+        }
+
+        stream_protocol::acceptor& raw_acceptor()
+        {
+            return acceptor_;
+        }
+
+        uint16_t port() const
+        {
+            return 0;
+        }
+
+        std::string url_display(bool) const
+        {
+            return "unix://" + acceptor_.local_endpoint().path();
+        }
+
+        stream_protocol::acceptor acceptor_;
+    };
+
+    template<typename Handler, typename Acceptor = TCPAcceptor, typename Adaptor = SocketAdaptor, typename... Middlewares>
     class Server
     {
     public:
       Server(Handler* handler,
-             const tcp::endpoint& endpoint,
+             const typename Acceptor::endpoint& endpoint,
              std::string server_name = std::string("Crow/") + VERSION,
              std::tuple<Middlewares...>* middlewares = nullptr,
              uint16_t concurrency = 1,
@@ -11060,12 +11246,13 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                   });
             }
 
-            handler_->port(acceptor_.local_endpoint().port());
+            if (acceptor_.port() != 0)
+                handler_->port(acceptor_.port());
 
 
             CROW_LOG_INFO << server_name_
-                          << " server is running at " << (handler_->ssl_used() ? "https://" : "http://")
-                          << acceptor_.local_endpoint().address() << ":" << acceptor_.local_endpoint().port() << " using " << concurrency_ << " threads";
+                          << " server is running at " << acceptor_.url_display(handler_->ssl_used())
+                          << " using " << concurrency_ << " threads";
             CROW_LOG_INFO << "Call `app.loglevel(crow::LogLevel::Warning)` to hide Info level logs.";
 
             signals_.async_wait(
@@ -11104,7 +11291,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         }
 
         uint16_t port() const {
-            return acceptor_.local_endpoint().port();
+            return acceptor_.port();
         }
 
         /// Wait until the server has properly started or until timeout
@@ -11158,7 +11345,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
                   ic, handler_, server_name_, middlewares_,
                   get_cached_date_str_pool_[context_idx], *task_timer_pool_[context_idx], adaptor_ctx_, task_queue_length_pool_[context_idx]);
 
-                acceptor_.async_accept(
+                acceptor_.raw_acceptor().async_accept(
                   p->socket(),
                   [this, p, &ic, context_idx](error_code ec) {
                       if (!ec)
@@ -11191,7 +11378,7 @@ namespace crow // NOTE: Already documented in "crow/app.h"
         asio::io_context io_context_;
         std::vector<detail::task_timer*> task_timer_pool_;
         std::vector<std::function<std::string()>> get_cached_date_str_pool_;
-        tcp::acceptor acceptor_;
+        Acceptor acceptor_;
         bool shutting_down_ = false;
         bool server_started_{false};
         std::condition_variable cv_started_;
@@ -12205,6 +12392,11 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             res = response(404);
             res.end();
         }
+        virtual void handle_upgrade(const request&, response& res, UnixSocketAdaptor&&)
+        {
+            res = response(404);
+            res.end();
+        }
 #ifdef CROW_ENABLE_SSL
         virtual void handle_upgrade(const request&, response& res, SSLAdaptor&&)
         {
@@ -12526,6 +12718,11 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             max_payload_ = max_payload_override_ ? max_payload_ : app_->websocket_max_payload();
             new crow::websocket::Connection<SocketAdaptor, App>(req, std::move(adaptor), app_, max_payload_, subprotocols_, open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_, mirror_protocols_);
         }
+        void handle_upgrade(const request& req, response&, UnixSocketAdaptor&& adaptor) override
+        {
+            max_payload_ = max_payload_override_ ? max_payload_ : app_->websocket_max_payload();
+            new crow::websocket::Connection<UnixSocketAdaptor, App>(req, std::move(adaptor), app_, max_payload_, subprotocols_, open_handler_, message_handler_, close_handler_, error_handler_, accept_handler_, mirror_protocols_);
+        }
 #ifdef CROW_ENABLE_SSL
         void handle_upgrade(const request& req, response&, SSLAdaptor&& adaptor) override
         {
@@ -14325,11 +14522,14 @@ namespace crow
         using self_t = Crow;
 
         /// \brief The HTTP server
-        using server_t = Server<Crow, SocketAdaptor, Middlewares...>;
+        using server_t = Server<Crow, TCPAcceptor, SocketAdaptor, Middlewares...>;
+
+        /// \brief An HTTP server that runs on a unix domain socket
+        using unix_server_t = Server<Crow, UnixSocketAcceptor, UnixSocketAdaptor, Middlewares...>;
 
 #ifdef CROW_ENABLE_SSL
         /// \brief An HTTP server that runs on SSL with an SSLAdaptor
-        using ssl_server_t = Server<Crow, SSLAdaptor, Middlewares...>;
+        using ssl_server_t = Server<Crow, TCPAcceptor, SSLAdaptor, Middlewares...>;
 #endif
         Crow()
         {}
@@ -14472,6 +14672,27 @@ namespace crow
             return bindaddr_;
         }
 
+        /// \brief Also handle requests on a unix domain socket at the path,
+        /// e.g., from a local reverse proxy. Its permissions are set to mode
+        self_t& local_socket_path(std::string path, unsigned mode = 0660)
+        {
+            local_socket_path_ = path;
+            local_socket_mode_ = mode;
+            return *this;
+        }
+
+        /// \brief Handle requests only on the unix domain socket, not on TCP
+        self_t& local_socket_only(bool only = true)
+        {
+            local_socket_only_ = only;
+            return *this;
+        }
+
+        std::string local_socket_path()
+        {
+            return local_socket_path_;
+        }
+
         /// \brief Run the server on multiple threads using all available threads
         self_t& multithreaded()
         {
@@ -14629,6 +14850,62 @@ namespace crow
 #endif
             validate();
 
+            std::future<void> unix_server_run;
+
+            if (!local_socket_path_.empty())
+            {
+                try
+                {
+                    unix_server_ = std::move(std::unique_ptr<unix_server_t>(new unix_server_t(this, UnixSocketAcceptor::endpoint{local_socket_path_, local_socket_mode_}, server_name_, &middlewares_, concurrency_, timeout_, nullptr)));
+                }
+                catch (std::exception& e)
+                {
+                    // as with the TCP server, failing to listen is fatal
+                    CROW_LOG_ERROR << "Can not listen on unix domain socket \"" << local_socket_path_ << "\": " << e.what();
+                    throw;
+                }
+
+                unix_server_->signal_clear();
+                for (auto snum : signals_)
+                {
+                    unix_server_->signal_add(snum);
+                }
+
+                if (local_socket_only_)
+                {
+                    notify_server_start();
+                    unix_server_->run();
+                    remove_local_socket();
+                    return;
+                }
+
+                // the TCP server blocks below, so the unix one
+                // runs alongside it on its own thread
+                unix_server_run = std::async(std::launch::async, [this] {
+                    unix_server_->run();
+                });
+            }
+
+            // the unix server runs until the TCP one stops, so if the
+            // TCP one fails to start, the unix one must be stopped too,
+            // or the destructor of unix_server_run would block forever
+            struct unix_server_guard
+            {
+                self_t& app;
+                std::future<void>& server_run;
+
+                ~unix_server_guard()
+                {
+                    if (!server_run.valid())
+                        return;
+                    // stop() is not safe before the server has set up its threads
+                    app.unix_server_->wait_for_start(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+                    app.unix_server_->stop();
+                    server_run.wait();
+                    app.remove_local_socket();
+                }
+            } stop_unix_server{*this, unix_server_run};
+
             error_code ec;
             asio::ip::address addr = asio::ip::make_address(bindaddr_,ec);
             if (ec){
@@ -14678,6 +14955,8 @@ namespace crow
         /// \brief Stop the server
         void stop()
         {
+            if (unix_server_) { unix_server_->stop(); }
+
 #ifdef CROW_ENABLE_SSL
             if (ssl_used_)
             {
@@ -14908,6 +15187,21 @@ namespace crow
 
         std::unique_ptr<server_t> server_;
 
+        /// Removes the socket made by the unix server once it stopped.
+        /// Anything else at the path, e.g., a file made there in the
+        /// meantime, is left alone.
+        void remove_local_socket()
+        {
+            struct stat st;
+            if (::lstat(local_socket_path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+                ::unlink(local_socket_path_.c_str());
+        }
+
+        std::unique_ptr<unix_server_t> unix_server_;
+        std::string local_socket_path_;
+        unsigned local_socket_mode_{0660};
+        bool local_socket_only_{false};
+
         std::vector<int> signals_{SIGINT, SIGTERM};
 
         bool server_started_{false};
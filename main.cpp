@@ -2,6 +2,12 @@
 #define CROW_MAIN
 
 #include "src/page.h"
+#include "src/AdmissionControl.h"
+#include "src/RateLimiter.h"
+#include "src/ComputeExecutor.h"
+#include "src/LiveUpdates.h"
+#include "src/RequestMetrics.h"
+#include "src/ServerTiming.h"
 
 #include "ext/crow_all.h"
 #include "src/CmdLineOptions.h"
@@ -29,12 +35,24 @@ struct htmlresponse: public crow::response
 struct jsonresponse: public crow::response
 {
     jsonresponse(const nlohmann::json& _body)
-            : crow::response {_body.dump()}
+            : jsonresponse {serialize(_body)}
+    {}
+
+    // for already serialized json
+    jsonresponse(string&& _body)
+            : crow::response {std::move(_body)}
     {
         add_header("Access-Control-Allow-Origin", "*");
         add_header("Access-Control-Allow-Headers", "Content-Type");
         add_header("Content-Type", "application/json");
     }
+
+    static string
+    serialize(const nlohmann::json& _body)
+    {
+        xmreg::RequestTimings::phase timer {xmreg::RequestTimings::serialize};
+        return _body.dump();
+    }
 };
 }
 
@@ -55,6 +73,9 @@ main(int ac, const char* av[])
 
     auto port_opt                      = opts.get_option<string>("port");
     auto bindaddr_opt                  = opts.get_option<string>("bindaddr");
+    auto unix_socket_opt               = opts.get_option<string>("unix-socket");
+    auto unix_socket_mode_opt          = opts.get_option<string>("unix-socket-mode");
+    auto unix_socket_only_opt          = opts.get_option<bool>("unix-socket-only");
     auto bc_path_opt                   = opts.get_option<string>("bc-path");
     auto daemon_url_opt                = opts.get_option<string>("daemon-url");
     auto ssl_crt_file_opt              = opts.get_option<string>("ssl-crt-file");
@@ -65,12 +86,18 @@ main(int ac, const char* av[])
     auto mainnet_url                   = opts.get_option<string>("mainnet-url");
     auto mempool_info_timeout_opt      = opts.get_option<string>("mempool-info-timeout");
     auto mempool_refresh_time_opt      = opts.get_option<string>("mempool-refresh-time");
+    auto mempool_max_full_txs_size_opt = opts.get_option<string>("mempool-max-full-txs-size");
     auto daemon_login_opt              = opts.get_option<string>("daemon-login");
+    auto daemon_rpc_connections_opt    = opts.get_option<string>("daemon-rpc-connections");
+    auto daemon_rpc_timeout_opt        = opts.get_option<string>("daemon-rpc-timeout");
+    auto daemon_rpc_cache_ttl_opt      = opts.get_option<string>("daemon-rpc-cache-ttl");
     auto testnet_opt                   = opts.get_option<bool>("testnet");
     auto stagenet_opt                  = opts.get_option<bool>("stagenet");
     auto enable_key_image_checker_opt  = opts.get_option<bool>("enable-key-image-checker");
     auto enable_output_key_checker_opt = opts.get_option<bool>("enable-output-key-checker");
     auto enable_autorefresh_option_opt = opts.get_option<bool>("enable-autorefresh-option");
+    auto enable_live_updates_opt       = opts.get_option<bool>("enable-live-updates");
+    auto live_updates_max_viewers_opt  = opts.get_option<size_t>("live-updates-max-viewers");
     auto enable_pusher_opt             = opts.get_option<bool>("enable-pusher");
     auto enable_randomx_opt            = opts.get_option<bool>("enable-randomx");
     auto enable_mixin_details_opt      = opts.get_option<bool>("enable-mixin-details");
@@ -78,7 +105,24 @@ main(int ac, const char* av[])
     auto enable_as_hex_opt             = opts.get_option<bool>("enable-as-hex");
     auto enable_mixin_guess_opt        = opts.get_option<bool>("enable-mixin-guess");
     auto concurrency_opt               = opts.get_option<size_t>("concurrency");
+    auto heavy_routes_concurrency_opt  = opts.get_option<size_t>("heavy-routes-concurrency");
+    auto rate_limit_opt                = opts.get_option<size_t>("rate-limit");
+    auto rate_limit_burst_opt          = opts.get_option<size_t>("rate-limit-burst");
+    auto rate_limit_heavy_cost_opt     = opts.get_option<size_t>("rate-limit-heavy-cost");
+    auto trusted_proxies_opt           = opts.get_option<string>("trusted-proxies");
+    auto compute_threads_opt           = opts.get_option<size_t>("compute-threads");
+    auto compute_queue_opt             = opts.get_option<size_t>("compute-queue");
+    auto request_timeout_opt           = opts.get_option<size_t>("request-timeout");
+    auto enable_server_timing_opt      = opts.get_option<bool>("enable-server-timing");
+    auto slow_request_time_opt         = opts.get_option<size_t>("slow-request-time");
+    auto emission_threads_opt          = opts.get_option<size_t>("emission-threads");
     auto enable_emission_monitor_opt   = opts.get_option<bool>("enable-emission-monitor");
+    auto enable_chain_stats_opt        = opts.get_option<bool>("enable-chain-stats");
+    auto enable_metrics_opt            = opts.get_option<bool>("enable-metrics");
+    auto disable_change_detection_opt  = opts.get_option<bool>("disable-change-detection");
+    auto change_poll_min_time_opt      = opts.get_option<string>("change-poll-min-time");
+    auto change_poll_max_time_opt      = opts.get_option<string>("change-poll-max-time");
+    auto notify_socket_opt             = opts.get_option<string>("notify-socket");
 
 
     bool testnet                      {*testnet_opt};
@@ -98,12 +142,16 @@ main(int ac, const char* av[])
     bool enable_randomx               {*enable_randomx_opt};
     bool enable_key_image_checker     {*enable_key_image_checker_opt};
     bool enable_autorefresh_option    {*enable_autorefresh_option_opt};
+    bool enable_live_updates          {*enable_live_updates_opt};
     bool enable_output_key_checker    {*enable_output_key_checker_opt};
     bool enable_mixin_details         {*enable_mixin_details_opt};
     bool enable_mixin_guess           {*enable_mixin_guess_opt};
     bool enable_json_api              {*enable_json_api_opt};
     bool enable_as_hex                {*enable_as_hex_opt};
     bool enable_emission_monitor      {*enable_emission_monitor_opt};
+    bool enable_chain_stats           {*enable_chain_stats_opt};
+    bool enable_metrics               {*enable_metrics_opt};
+    bool disable_change_detection     {*disable_change_detection_opt};
 
     //temprorary disable randomx
     if (enable_randomx == true) {
@@ -111,6 +159,10 @@ main(int ac, const char* av[])
         enable_randomx = false;
     }
 
+    // live updates are pushed to autorefresh pages
+    if (enable_live_updates)
+        enable_autorefresh_option = true;
+
     // set  monero log output level
     uint32_t log_level = 0;
     mlog_configure("", true);
@@ -161,6 +213,24 @@ main(int ac, const char* av[])
        // cout << "pass: " << std::string(pass.data(), pass.size()) << endl;
     }
 
+    // used by all rpccalls, i.e., in the page and the mempool thread
+    try
+    {
+        xmreg::rpccalls::default_max_connections
+                = boost::lexical_cast<size_t>(*daemon_rpc_connections_opt);
+        xmreg::rpccalls::default_timeout
+                = boost::lexical_cast<uint64_t>(*daemon_rpc_timeout_opt);
+        xmreg::rpccalls::cache_ttl
+                = boost::lexical_cast<uint64_t>(*daemon_rpc_cache_ttl_opt);
+    }
+    catch (boost::bad_lexical_cast &e)
+    {
+        cout << "Cant cast " << (*daemon_rpc_connections_opt)
+             << ", " << (*daemon_rpc_timeout_opt)
+             << " or " << (*daemon_rpc_cache_ttl_opt)
+             <<" into numbers. Using default values.\n";
+    }
+
 
     // check if ssl enabled and files exist
 
@@ -234,6 +304,34 @@ main(int ac, const char* av[])
 
     uint64_t mempool_refresh_time {10};
 
+    if (!disable_change_detection)
+    {
+        // This starts new thread, which checks lmdb
+        // for new blocks and changes in the mempool,
+        // and wakes up emission and mempool threads
+        // when they happen.
+
+        try
+        {
+            xmreg::ChainNotifier::min_poll_interval
+                    = boost::lexical_cast<uint64_t>(*change_poll_min_time_opt);
+            xmreg::ChainNotifier::max_poll_interval
+                    = boost::lexical_cast<uint64_t>(*change_poll_max_time_opt);
+        }
+        catch (boost::bad_lexical_cast &e)
+        {
+            cout << "Cant cast " << (*change_poll_min_time_opt)
+                 << " or " << (*change_poll_max_time_opt)
+                 << " into numbers. Using default values.\n";
+        }
+
+        if (notify_socket_opt)
+            xmreg::ChainNotifier::notify_socket_path = *notify_socket_opt;
+
+        xmreg::ChainNotifier::set_blockchain_variables(core_storage);
+        xmreg::ChainNotifier::start_notifier_thread();
+    }
+
 
     if (enable_emission_monitor == true)
     {
@@ -241,14 +339,14 @@ main(int ac, const char* av[])
         // to calculate, store and monitor
         // current total Monero emission amount.
 
-        // This thread stores the current emission
+        // This thread stores emission of every block
         // which it has caluclated in
-        // <blockchain_path>/emission_amount.txt file,
-        // e.g., ~/.bitmonero/lmdb/emission_amount.txt.
+        // <blockchain_path>/emission_ledger.bin file,
+        // e.g., ~/.bitmonero/lmdb/emission_ledger.bin.
         // So instead of calcualting the emission
         // from scrach whenever the explorer is started,
-        // the thread is initalized with the values
-        // found in emission_amount.txt file.
+        // the thread continues from the last block
+        // found in emission_ledger.bin file.
 
         xmreg::CurrentBlockchainStatus::blockchain_path
                 = blockchain_path;
@@ -256,6 +354,8 @@ main(int ac, const char* av[])
                 = nettype;
         xmreg::CurrentBlockchainStatus::daemon_url
                 = daemon_url;
+        xmreg::CurrentBlockchainStatus::catchup_threads
+                = *emission_threads_opt;
         xmreg::CurrentBlockchainStatus::set_blockchain_variables(
                 &mcore, core_storage);
 
@@ -266,6 +366,21 @@ main(int ac, const char* av[])
         xmreg::CurrentBlockchainStatus::start_monitor_blockchain_thread();
     }
 
+    if (enable_chain_stats == true)
+    {
+        // This thread aggregates daily and weekly chain statistics
+        // and stores them in <blockchain_path>/chain_stats.bin file.
+
+        xmreg::ChainStats::blockchain_path
+                = blockchain_path;
+        xmreg::ChainStats::catchup_threads
+                = *emission_threads_opt;
+        xmreg::ChainStats::set_blockchain_variables(
+                &mcore, core_storage);
+
+        xmreg::ChainStats::start_chain_stats_thread();
+    }
+
 
     xmreg::MempoolStatus::blockchain_path
             = blockchain_path;
@@ -295,6 +410,19 @@ main(int ac, const char* av[])
              << endl;
     }
 
+    try
+    {
+        xmreg::MempoolStatus::max_full_txs_size
+                = boost::lexical_cast<uint64_t>(*mempool_max_full_txs_size_opt)
+                  * 1024 * 1024;
+    }
+    catch (boost::bad_lexical_cast &e)
+    {
+        cout << "Cant cast " << (*mempool_max_full_txs_size_opt)
+             <<" into number. Using default value."
+             << endl;
+    }
+
     // launch the status monitoring thread so that it keeps track of blockchain
     // info, e.g., current height. Information from this thread is used
     // by tx searching threads that are launched for each user independently,
@@ -314,6 +442,7 @@ main(int ac, const char* av[])
                           enable_key_image_checker,
                           enable_output_key_checker,
                           enable_autorefresh_option,
+                          enable_live_updates,
                           enable_mixin_details,
                           enable_mixin_guess,
                           no_blocks_on_index,
@@ -323,8 +452,215 @@ main(int ac, const char* av[])
                           *mainnet_url,
                           daemon_rpc_login);
 
+    // expensive page handlers run on their own threads, so
+    // that crow threads are free to serve other pages
+    xmreg::ComputeExecutor compute_executor;
+
+    xmreg::RequestDeadline::request_timeout = *request_timeout_opt;
+
+    // phases of requests, e.g., lmdb reads or rendering,
+    // are timed only if they are shown or logged
+    xmreg::RequestTimings::enable_server_timing = *enable_server_timing_opt;
+    xmreg::RequestTimings::slow_request_time    = *slow_request_time_opt;
+
+    compute_executor.start(*compute_threads_opt, *compute_queue_opt);
+
+    cout << "Expensive queries handled by "
+         << compute_executor.get_stats().no_threads
+         << " compute threads" << endl;
+
+    // pushes new blocks and mempool txs to autorefresh pages
+    xmreg::LiveUpdates live_updates;
+
+    if (enable_live_updates)
+    {
+        live_updates.start(core_storage,
+                           *live_updates_max_viewers_opt,
+                           1000);
+    }
+
     // crow instance
-    crow::SimpleApp app;
+    // request metrics go first, so that they count everything.
+    // rate limiter goes next, so that limited clients
+    // dont take slots of expensive routes
+    crow::App<xmreg::RequestMetrics,
+              xmreg::ServerTiming,
+              xmreg::RateLimiter,
+              xmreg::AdmissionControl> app;
+
+    // limit expensive routes, so that they cant take
+    // all http threads from cheap ones. By default, as many
+    // as compute threads and their queue can take, so that
+    // the compute queue is where expensive queries wait, and
+    // they get 503 only when it is full.
+    {
+        xmreg::ComputeExecutor::stats compute_stats
+                = compute_executor.get_stats();
+
+        size_t compute_capacity
+                = compute_stats.no_threads + compute_stats.max_queued;
+
+        size_t heavy_routes_concurrency = *heavy_routes_concurrency_opt > 0
+                ? *heavy_routes_concurrency_opt
+                : compute_capacity;
+
+        // a lower limit would leave compute threads
+        // or their queue unused
+        if (heavy_routes_concurrency < compute_capacity)
+        {
+            cout << "Expensive queries limit raised from "
+                 << heavy_routes_concurrency << " to " << compute_capacity
+                 << ", i.e., compute threads plus compute queue" << endl;
+
+            heavy_routes_concurrency = compute_capacity;
+        }
+
+        auto& admission = app.get_middleware<xmreg::AdmissionControl>();
+
+        admission.set_limits(admission.heavy_routes,
+                             heavy_routes_concurrency);
+
+        cout << "Expensive queries limited to " << heavy_routes_concurrency
+             << " at the same time" << endl;
+    }
+
+    // limit queries from a single client, e.g., scrapers
+    if (*rate_limit_opt > 0)
+    {
+        set<string> trusted_proxies;
+
+        if (trusted_proxies_opt)
+        {
+            vector<string> addresses;
+
+            boost::split(addresses, *trusted_proxies_opt,
+                         boost::is_any_of(","));
+
+            for (string& address: addresses)
+            {
+                boost::trim(address);
+
+                if (!address.empty())
+                    trusted_proxies.insert(address);
+            }
+        }
+
+        auto& rate_limiter = app.get_middleware<xmreg::RateLimiter>();
+
+        rate_limiter.set_limits(*rate_limit_opt,
+                                *rate_limit_burst_opt,
+                                *rate_limit_heavy_cost_opt,
+                                std::move(trusted_proxies));
+
+        cout << "Queries limited to " << *rate_limit_opt
+             << " per second per client" << endl;
+    }
+
+    // values kept by other components are read
+    // only when /metrics is requested
+    if (enable_metrics)
+    {
+        using xmreg::Metrics;
+
+        Metrics::add_gauge("xmrblocks_mempool_txs",
+                "Number of txs in the mempool", []() {
+            return static_cast<double>(xmreg::MempoolStatus::mempool_no);
+        });
+
+        Metrics::add_gauge("xmrblocks_mempool_size_bytes",
+                "Size of txs in the mempool", []() {
+            return static_cast<double>(xmreg::MempoolStatus::mempool_size);
+        });
+
+        if (enable_emission_monitor)
+        {
+            Metrics::add_gauge("xmrblocks_emission_blocks",
+                    "Number of blocks counted by emission monitor", []() {
+                return static_cast<double>(xmreg::CurrentBlockchainStatus
+                        ::total_emission_atomic.load().blk_no);
+            });
+
+            Metrics::add_gauge("xmrblocks_emission_chain_height",
+                    "Blockchain height seen by emission monitor", []() {
+                return static_cast<double>(xmreg::CurrentBlockchainStatus
+                        ::current_height.load());
+            });
+        }
+
+        auto add_compute_gauge = [&](string const& name, string const& help,
+                                     std::function<double(xmreg::ComputeExecutor::stats const&)> read,
+                                     bool is_counter = false) {
+            auto read_stats = [&compute_executor, read]() {
+                return read(compute_executor.get_stats());
+            };
+
+            if (is_counter)
+                Metrics::add_counter(name, help, read_stats);
+            else
+                Metrics::add_gauge(name, help, read_stats);
+        };
+
+        add_compute_gauge("xmrblocks_compute_threads",
+                "Number of compute threads",
+                [](xmreg::ComputeExecutor::stats const& s) { return s.no_threads; });
+
+        add_compute_gauge("xmrblocks_compute_queued",
+                "Number of expensive requests waiting for a compute thread",
+                [](xmreg::ComputeExecutor::stats const& s) { return s.no_queued; });
+
+        add_compute_gauge("xmrblocks_compute_active",
+                "Number of expensive requests being computed",
+                [](xmreg::ComputeExecutor::stats const& s) { return s.no_active; });
+
+        add_compute_gauge("xmrblocks_compute_completed_total",
+                "Number of computed expensive requests",
+                [](xmreg::ComputeExecutor::stats const& s) { return s.no_completed; },
+                true);
+
+        add_compute_gauge("xmrblocks_compute_rejected_total",
+                "Number of expensive requests rejected for a full queue",
+                [](xmreg::ComputeExecutor::stats const& s) { return s.no_rejected; },
+                true);
+
+        auto& admission = app.get_middleware<xmreg::AdmissionControl>();
+
+        for (xmreg::AdmissionControl::route_class* rc
+                : {&admission.heavy_routes, &admission.default_routes})
+        {
+            Metrics::add_gauge("xmrblocks_admission_active",
+                    "Number of requests being handled", [rc]() {
+                std::lock_guard<std::mutex> lck (rc->class_mutx);
+                return static_cast<double>(rc->no_active);
+            }, "routes", rc->name);
+
+            Metrics::add_counter("xmrblocks_admission_admitted_total",
+                    "Number of admitted requests", [rc]() {
+                return static_cast<double>(rc->no_admitted);
+            }, "routes", rc->name);
+
+            Metrics::add_counter("xmrblocks_admission_rejected_total",
+                    "Number of requests rejected as too many", [rc]() {
+                return static_cast<double>(rc->no_rejected);
+            }, "routes", rc->name);
+        }
+
+        auto& rate_limiter = app.get_middleware<xmreg::RateLimiter>();
+
+        Metrics::add_counter("xmrblocks_rate_limited_total",
+                "Number of requests over the per client rate limit",
+                [&rate_limiter]() {
+            return static_cast<double>(rate_limiter.no_limited);
+        });
+
+        if (enable_live_updates)
+        {
+            Metrics::add_gauge("xmrblocks_live_updates_viewers",
+                    "Number of pages getting live updates",
+                    [&live_updates]() {
+                return static_cast<double>(live_updates.no_of_viewers());
+            });
+        }
+    }
 
     // get domian url based on the request
     auto get_domain = [&use_ssl](crow::request const& req) {
@@ -348,8 +684,10 @@ main(int ac, const char* av[])
     });
     
     CROW_ROUTE(app, "/randomx/<uint>")
-    ([&](size_t block_height) {
-        return myxmr::htmlresponse(xmrblocks.show_randomx(block_height));
+    ([&](const crow::request& req, crow::response& res, size_t block_height) {
+        compute_executor.dispatch(req, res, [&, block_height]() {
+            return myxmr::htmlresponse(xmrblocks.show_randomx(block_height));
+        });
     });
 
     CROW_ROUTE(app, "/block/<string>")
@@ -395,9 +733,12 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/blockhexcomplete/<uint>")
-        ([&](size_t block_height) {
-            return crow::response(
-                    xmrblocks.show_block_hex(block_height, true));
+        ([&](const crow::request& req, crow::response& res,
+             size_t block_height) {
+            compute_executor.dispatch(req, res, [&, block_height]() {
+                return crow::response(
+                        xmrblocks.show_block_hex(block_height, true));
+            });
         });
 
 //        CROW_ROUTE(app, "/ringmemberstxhex/<string>")
@@ -407,37 +748,73 @@ main(int ac, const char* av[])
 //        });
 
         CROW_ROUTE(app, "/ringmemberstxhex/<string>")
-        ([&](string tx_hash) {
-            return myxmr::jsonresponse {
-                xmrblocks.show_ringmemberstx_jsonhex(
-                        remove_bad_chars(tx_hash))};
+        ([&](const crow::request& req, crow::response& res,
+             string tx_hash) {
+            compute_executor.dispatch(req, res, [&, tx_hash]() {
+                return myxmr::jsonresponse {
+                    xmrblocks.show_ringmemberstx_jsonhex(
+                            remove_bad_chars(tx_hash))};
+            });
         });
 
     }
 
+    // only txs with ring signatures are expensive, and go to the
+    // compute threads, as in AdmissionControl::is_heavy_route.
+    // /tx/<hash>/0 is the same cheap page as /tx/<hash>
     CROW_ROUTE(app, "/tx/<string>/<uint>")
-    ([&](string tx_hash, uint16_t with_ring_signatures)
+    ([&](const crow::request& req, crow::response& res,
+         string tx_hash, uint16_t with_ring_signatures)
      {
-        return myxmr::htmlresponse(
-                xmrblocks.show_tx(remove_bad_chars(tx_hash), 
-                    with_ring_signatures));
+        if (with_ring_signatures == 0)
+        {
+            res = myxmr::htmlresponse(
+                    xmrblocks.show_tx(remove_bad_chars(tx_hash)));
+            res.end();
+            return;
+        }
+
+        compute_executor.dispatch(req, res,
+                                  [&, tx_hash, with_ring_signatures]() {
+            return myxmr::htmlresponse(
+                    xmrblocks.show_tx(remove_bad_chars(tx_hash),
+                        with_ring_signatures));
+        });
     });
     if (enable_autorefresh_option)
     {
         CROW_ROUTE(app, "/tx/<string>/<uint>/autorefresh")
-        ([&](string tx_hash, uint16_t with_ring_signature) {
+        ([&](const crow::request& req, crow::response& res,
+             string tx_hash, uint16_t with_ring_signature) {
             bool refresh_page {true};
-            return myxmr::htmlresponse(
-                xmrblocks.show_tx(remove_bad_chars(tx_hash), with_ring_signature, refresh_page));
+
+            if (with_ring_signature == 0)
+            {
+                res = myxmr::htmlresponse(
+                    xmrblocks.show_tx(remove_bad_chars(tx_hash), 0, refresh_page));
+                res.end();
+                return;
+            }
+
+            compute_executor.dispatch(req, res,
+                                      [&, tx_hash, with_ring_signature, refresh_page]() {
+                return myxmr::htmlresponse(
+                    xmrblocks.show_tx(remove_bad_chars(tx_hash), with_ring_signature, refresh_page));
+            });
         });
     }
 
     CROW_ROUTE(app, "/myoutputs").methods("POST"_method)
-    ([&](const crow::request& req) -> myxmr::htmlresponse
+    ([&](const crow::request& req, crow::response& res)
      {
+      string domain = get_domain(req);
 
+      compute_executor.dispatch(req, res,
+                                [&, req_body = req.body, domain]()
+                                        -> myxmr::htmlresponse
+      {
         map<std::string, std::string> post_body
-                = xmreg::parse_crow_post_data(req.body);
+                = xmreg::parse_crow_post_data(req_body);
 
         if (post_body.count("xmr_address") == 0
             || post_body.count("viewkey") == 0
@@ -454,37 +831,44 @@ main(int ac, const char* av[])
         // using tx pusher
         string raw_tx_data = remove_bad_chars(post_body["raw_tx_data"]);
 
-        string domain      =  get_domain(req);
-
         string response = xmrblocks.show_my_outputs(
                                          tx_hash, xmr_address,
                                          viewkey, raw_tx_data,
                                          domain);
 
         return myxmr::htmlresponse(std::move(response));
+      });
     });
 
     CROW_ROUTE(app, "/myoutputs/<string>/<string>/<string>")
-    ([&](const crow::request& req, string tx_hash,
+    ([&](const crow::request& req, crow::response& res, string tx_hash,
         string xmr_address, string viewkey)
      {
 
         string domain = get_domain(req);
 
-        return myxmr::htmlresponse(xmrblocks.show_my_outputs(
-                                         remove_bad_chars(tx_hash),
-                                         remove_bad_chars(xmr_address),
-                                         remove_bad_chars(viewkey),
-                                         string {},
-                                         domain));
+        compute_executor.dispatch(req, res,
+                [&, tx_hash, xmr_address, viewkey, domain]() {
+            return myxmr::htmlresponse(xmrblocks.show_my_outputs(
+                                             remove_bad_chars(tx_hash),
+                                             remove_bad_chars(xmr_address),
+                                             remove_bad_chars(viewkey),
+                                             string {},
+                                             domain));
+        });
     });
 
     CROW_ROUTE(app, "/prove").methods("POST"_method)
-        ([&](const crow::request& req) -> myxmr::htmlresponse 
+        ([&](const crow::request& req, crow::response& res)
          {
+          string domain = get_domain(req);
 
+          compute_executor.dispatch(req, res,
+                                    [&, req_body = req.body, domain]()
+                                            -> myxmr::htmlresponse
+          {
             map<std::string, std::string> post_body
-                    = xmreg::parse_crow_post_data(req.body);
+                    = xmreg::parse_crow_post_data(req_body);
 
             if (post_body.count("xmraddress") == 0
                 || post_body.count("txprvkey") == 0
@@ -502,29 +886,31 @@ main(int ac, const char* av[])
             // using tx pusher
             string raw_tx_data = remove_bad_chars(post_body["raw_tx_data"]);
 
-            string domain      = get_domain(req);
-
             return myxmr::htmlresponse(xmrblocks.show_prove(tx_hash,
                                         xmr_address,
                                         tx_prv_key,
                                         raw_tx_data,
                                         domain));
+          });
     });
 
 
     CROW_ROUTE(app, "/prove/<string>/<string>/<string>")
-    ([&](const crow::request& req, string tx_hash,
-         string xmr_address, string tx_prv_key) 
+    ([&](const crow::request& req, crow::response& res, string tx_hash,
+         string xmr_address, string tx_prv_key)
      {
 
         string domain = get_domain(req);
 
-        return myxmr::htmlresponse(xmrblocks.show_prove(
-                                    remove_bad_chars(tx_hash),
-                                    remove_bad_chars(xmr_address),
-                                    remove_bad_chars(tx_prv_key),
-                                    string {},
-                                    domain));
+        compute_executor.dispatch(req, res,
+                [&, tx_hash, xmr_address, tx_prv_key, domain]() {
+            return myxmr::htmlresponse(xmrblocks.show_prove(
+                                        remove_bad_chars(tx_hash),
+                                        remove_bad_chars(xmr_address),
+                                        remove_bad_chars(tx_prv_key),
+                                        string {},
+                                        domain));
+        });
     });
 
     if (enable_pusher)
@@ -535,11 +921,14 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/checkandpush").methods("POST"_method)
-        ([&](const crow::request& req) -> myxmr::htmlresponse
+        ([&](const crow::request& req, crow::response& res)
          {
-
+          compute_executor.dispatch(req, res,
+                                    [&, req_body = req.body]()
+                                            -> myxmr::htmlresponse
+          {
             map<std::string, std::string> post_body
-                    = xmreg::parse_crow_post_data(req.body);
+                    = xmreg::parse_crow_post_data(req_body);
 
             if (post_body.count("rawtxdata") == 0 
                     || post_body.count("action") == 0)
@@ -557,7 +946,7 @@ main(int ac, const char* av[])
                 return myxmr::htmlresponse(
                         xmrblocks.show_pushrawtx(raw_tx_data, action));
             return string("Provided action is neither check nor push");
-
+          });
         });
     }
 
@@ -569,11 +958,14 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/checkrawkeyimgs").methods("POST"_method)
-        ([&](const crow::request& req) -> myxmr::htmlresponse
+        ([&](const crow::request& req, crow::response& res)
          {
-
+          compute_executor.dispatch(req, res,
+                                    [&, req_body = req.body]()
+                                            -> myxmr::htmlresponse
+          {
             map<std::string, std::string> post_body
-                    = xmreg::parse_crow_post_data(req.body);
+                    = xmreg::parse_crow_post_data(req_body);
 
             if (post_body.count("rawkeyimgsdata") == 0)
             {
@@ -590,6 +982,7 @@ main(int ac, const char* av[])
 
             return myxmr::htmlresponse(
                     xmrblocks.show_checkrawkeyimgs(raw_data, viewkey));
+          });
         });
     }
 
@@ -602,11 +995,14 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/checkrawoutputkeys").methods("POST"_method)
-        ([&](const crow::request& req) -> myxmr::htmlresponse
+        ([&](const crow::request& req, crow::response& res)
          {
-
+          compute_executor.dispatch(req, res,
+                                    [&, req_body = req.body]()
+                                            -> myxmr::htmlresponse
+          {
             map<std::string, std::string> post_body
-                    = xmreg::parse_crow_post_data(req.body);
+                    = xmreg::parse_crow_post_data(req_body);
 
             if (post_body.count("rawoutputkeysdata") == 0)
             {
@@ -624,16 +1020,22 @@ main(int ac, const char* av[])
 
             return myxmr::htmlresponse(
                     xmrblocks.show_checkcheckrawoutput(raw_data, viewkey));
+          });
         });
     }
 
 
     CROW_ROUTE(app, "/search").methods("GET"_method)
-    ([&](const crow::request& req) {
-        return myxmr::htmlresponse(
-                xmrblocks.search(
-                    remove_bad_chars(
-                        string(req.url_params.get("value")))));
+    ([&](const crow::request& req, crow::response& res) {
+
+        char const* value = req.url_params.get("value");
+
+        string search_value = value ? value : "";
+
+        compute_executor.dispatch(req, res, [&, search_value]() {
+            return myxmr::htmlresponse(
+                    xmrblocks.search(remove_bad_chars(search_value)));
+        });
     });
 
     CROW_ROUTE(app, "/mempool")
@@ -647,10 +1049,10 @@ main(int ac, const char* av[])
         return myxmr::htmlresponse(xmrblocks.mempool(true));
     });
 
-//    CROW_ROUTE(app, "/altblocks")
-//    ([&](const crow::request& req) {
-//        return xmrblocks.altblocks();
-//    });
+    CROW_ROUTE(app, "/altblocks")
+    ([&]() {
+        return myxmr::htmlresponse(xmrblocks.altblocks());
+    });
 
     CROW_ROUTE(app, "/robots.txt")
     ([&]() {
@@ -681,11 +1083,12 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/api/detailedtransaction/<string>")
-        ([&](string tx_hash) {
-
-            myxmr::jsonresponse r{xmrblocks.json_detailedtransaction(remove_bad_chars(tx_hash))};
+        ([&](const crow::request& req, crow::response& res, string tx_hash) {
 
-            return r;
+            compute_executor.dispatch(req, res, [&, tx_hash]() {
+                return myxmr::jsonresponse {xmrblocks.json_detailedtransaction(
+                        remove_bad_chars(tx_hash))};
+            });
         });
 
         CROW_ROUTE(app, "/api/block/<string>")
@@ -731,20 +1134,30 @@ main(int ac, const char* av[])
             string limit = regex_search(req.raw_url, regex {"limit=\\d+"}) ?
                            req.url_params.get("limit") : "100000000";
 
-            myxmr::jsonresponse r{xmrblocks.json_mempool(
+            myxmr::jsonresponse r{xmrblocks.json_mempool_serialized(
                     remove_bad_chars(page), remove_bad_chars(limit))};
 
             return r;
         });
 
-        CROW_ROUTE(app, "/api/search/<string>")
-        ([&](string search_value) {
+        CROW_ROUTE(app, "/api/mempoolstats")
+        ([&]() {
 
-            myxmr::jsonresponse r{xmrblocks.json_search(remove_bad_chars(search_value))};
+            myxmr::jsonresponse r{xmrblocks.json_mempoolstats()};
 
             return r;
         });
 
+        CROW_ROUTE(app, "/api/search/<string>")
+        ([&](const crow::request& req, crow::response& res,
+             string search_value) {
+
+            compute_executor.dispatch(req, res, [&, search_value]() {
+                return myxmr::jsonresponse {xmrblocks.json_search(
+                        remove_bad_chars(search_value))};
+            });
+        });
+
         CROW_ROUTE(app, "/api/networkinfo")
         ([&]() {
 
@@ -753,8 +1166,33 @@ main(int ac, const char* av[])
             return r;
         });
 
-        CROW_ROUTE(app, "/api/emission")
-        ([&]() {
+        CROW_ROUTE(app, "/api/emission").methods("GET"_method)
+        ([&](const crow::request &req) {
+
+            // range form, i.e., emission of blocks from start to end,
+            // or supply at the given height, i.e., from 0 to height.
+            // A missing bound is passed as empty, so that
+            // json_emission_range responds with fail.
+            char const* height = req.url_params.get("height");
+            char const* start  = req.url_params.get("start");
+            char const* end    = req.url_params.get("end");
+
+            if (height && !start && !end)
+            {
+                myxmr::jsonresponse r{xmrblocks.json_emission_range(
+                        "0", remove_bad_chars(height))};
+
+                return r;
+            }
+
+            if (height || start || end)
+            {
+                myxmr::jsonresponse r{xmrblocks.json_emission_range(
+                        remove_bad_chars(!height && start ? start : ""),
+                        remove_bad_chars(!height && end ? end : ""))};
+
+                return r;
+            }
 
             myxmr::jsonresponse r{xmrblocks.json_emission()};
 
@@ -762,7 +1200,7 @@ main(int ac, const char* av[])
         });
 
         CROW_ROUTE(app, "/api/outputs").methods("GET"_method)
-        ([&](const crow::request &req) {
+        ([&](const crow::request &req, crow::response &res) {
 
             string tx_hash = regex_search(req.raw_url, regex {"txhash=\\w+"}) ?
                              req.url_params.get("txhash") : "";
@@ -786,17 +1224,18 @@ main(int ac, const char* av[])
                 cerr << "Cant parse tx_prove as bool. Using default value" << endl;
             }
 
-            myxmr::jsonresponse r{xmrblocks.json_outputs(
-                    remove_bad_chars(tx_hash),
-                    remove_bad_chars(address),
-                    remove_bad_chars(viewkey),
-                    tx_prove)};
-
-            return r;
+            compute_executor.dispatch(req, res,
+                    [&, tx_hash, address, viewkey, tx_prove]() {
+                return myxmr::jsonresponse {xmrblocks.json_outputs(
+                        remove_bad_chars(tx_hash),
+                        remove_bad_chars(address),
+                        remove_bad_chars(viewkey),
+                        tx_prove)};
+            });
         });
 
         CROW_ROUTE(app, "/api/outputsblocks").methods("GET"_method)
-        ([&](const crow::request &req) {
+        ([&](const crow::request &req, crow::response &res) {
 
             string startblock = regex_search(req.raw_url, regex {"startblock=\\d+"}) ?
                            req.url_params.get("startblock") : "";
@@ -826,12 +1265,26 @@ main(int ac, const char* av[])
                      << endl;
             }
 
-            myxmr::jsonresponse r{xmrblocks.json_outputsblocks(
-                    remove_bad_chars(startblock),
-                    remove_bad_chars(endblock),
-                    remove_bad_chars(address),
-                    remove_bad_chars(viewkey),
-                    in_mempool_aswell)};
+            compute_executor.dispatch(req, res,
+                    [&, startblock, endblock, address,
+                        viewkey, in_mempool_aswell]() {
+                return myxmr::jsonresponse {xmrblocks.json_outputsblocks(
+                        remove_bad_chars(startblock),
+                        remove_bad_chars(endblock),
+                        remove_bad_chars(address),
+                        remove_bad_chars(viewkey),
+                        in_mempool_aswell)};
+            });
+        });
+
+        CROW_ROUTE(app, "/api/chainstats").methods("GET"_method)
+        ([&](const crow::request &req) {
+
+            string period = regex_search(req.raw_url, regex {"period=\\w+"}) ?
+                            req.url_params.get("period") : "day";
+
+            myxmr::jsonresponse r{xmrblocks.json_chainstats_serialized(
+                    remove_bad_chars(period))};
 
             return r;
         });
@@ -856,28 +1309,125 @@ main(int ac, const char* av[])
         });
     }
 
-    // run the crow http server
+    if (enable_metrics)
+    {
+        CROW_ROUTE(app, "/metrics")
+        ([&]() {
+            crow::response res {xmreg::Metrics::render()};
+            res.set_header("Content-Type", "text/plain; version=0.0.4");
+            return res;
+        });
+    }
 
-    if (use_ssl)
+    if (enable_live_updates)
     {
-        cout << "Staring in ssl mode" << endl;
-        app.bindaddr(bindaddr).port(app_port).ssl_file(
-                ssl_crt_file, ssl_key_file)
-                .multithreaded().run();
+        CROW_WEBSOCKET_ROUTE(app, "/live")
+        .onaccept([&](crow::request const&, void**) {
+            return live_updates.can_accept();
+        })
+        .onopen([&](crow::websocket::connection& conn) {
+            if (!live_updates.add_viewer(&conn))
+                conn.close("Too many viewers");
+        })
+        .onclose([&](crow::websocket::connection& conn,
+                     string const&, uint16_t) {
+            live_updates.remove_viewer(&conn);
+        });
     }
-    else
+
+    // local reverse proxies, e.g., nginx or tor, can connect
+    // through unix domain socket instead of loopback tcp
+    if (unix_socket_opt)
+    {
+        unsigned unix_socket_mode {0660};
+
+        try
+        {
+            unix_socket_mode = std::stoul(*unix_socket_mode_opt, nullptr, 8);
+        }
+        catch (std::exception const&)
+        {
+            cerr << "Cant parse unix socket mode: " << *unix_socket_mode_opt << endl;
+            return EXIT_FAILURE;
+        }
+
+        app.local_socket_path(*unix_socket_opt, unix_socket_mode)
+           .local_socket_only(*unix_socket_only_opt);
+
+        cout << "Listening on unix socket " << *unix_socket_opt << endl;
+    }
+    else if (*unix_socket_only_opt)
+    {
+        cerr << "--unix-socket-only requires --unix-socket" << endl;
+        return EXIT_FAILURE;
+    }
+
+    // run the crow http server. If it cant listen, e.g., on
+    // the unix socket, the threads are still finished below,
+    // but the explorer exits with failure.
+
+    bool server_failed {false};
+
+    try
     {
-        cout << "Staring in non-ssl mode" << endl;
-        if (*concurrency_opt == 0)
+        if (use_ssl)
         {
-            app.bindaddr(bindaddr).port(app_port).multithreaded().run();
+            cout << "Staring in ssl mode" << endl;
+            app.bindaddr(bindaddr).port(app_port).ssl_file(
+                    ssl_crt_file, ssl_key_file)
+                    .multithreaded().run();
         }
         else
         {
-            app.bindaddr(bindaddr).port(app_port)
-                .concurrency(*concurrency_opt).run();
+            cout << "Staring in non-ssl mode" << endl;
+            if (*concurrency_opt == 0)
+            {
+                app.bindaddr(bindaddr).port(app_port).multithreaded().run();
+            }
+            else
+            {
+                app.bindaddr(bindaddr).port(app_port)
+                    .concurrency(*concurrency_opt).run();
+            }
         }
     }
+    catch (std::exception const& e)
+    {
+        cerr << "Http server failed: " << e.what() << endl;
+        server_failed = true;
+    }
+
+    if (xmreg::ChainNotifier::is_thread_running())
+    {
+        // finish change detection thread first, so that
+        // the other threads dont wait for it anymore.
+
+        cout << "Waiting for change detection thread to finish." << endl;
+
+        xmreg::ChainNotifier::stop_notifier_thread();
+
+        cout << "Change detection thread finished." << endl;
+    }
+
+    if (enable_live_updates)
+    {
+        cout << "Waiting for live updates thread to finish." << endl;
+        live_updates.stop();
+    }
+
+    cout << "Waiting for compute threads to finish." << endl;
+
+    compute_executor.stop();
+
+    if (enable_chain_stats == true)
+    {
+        cout << "Waiting for chain stats thread to finish." << endl;
+
+        xmreg::ChainStats::m_thread.interrupt();
+        xmreg::ChainStats::m_thread.join();
+
+        cout << "Chain stats thread finished." << endl;
+    }
 
     if (enable_emission_monitor == true)
     {
@@ -902,5 +1452,5 @@ main(int ac, const char* av[])
 
     cout << "The explorer is terminating." << endl;
 
-    return EXIT_SUCCESS;
+    return server_failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -0,0 +1,166 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_ADMISSIONCONTROL_H
+#define XMRBLOCKS_ADMISSIONCONTROL_H
+
+#include "../ext/crow_all.h"
+
+#include <atomic>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Crow middleware limiting how many requests of a given class
+ * of routes are handled at the same time.
+ *
+ * All routes share crow's worker threads, so a burst of expensive
+ * requests, e.g., decoding outputs or txs with ring signatures,
+ * could take all of them and the front page would time out.
+ *
+ * Requests over the limit of their class are rejected at once with
+ * 503 and Retry-After. They never wait for a slot here, as that would
+ * block the crow thread, and with it all other connections of that
+ * thread, cheap ones included. Admitted expensive requests, which
+ * wait for a compute thread, wait in ComputeExecutor's queue instead.
+ */
+struct AdmissionControl
+{
+    struct route_class
+    {
+        string name;
+
+        // 0 means no limit
+        size_t max_concurrent {0};
+
+        size_t no_active {0};
+
+        std::atomic<uint64_t> no_admitted {0};
+        std::atomic<uint64_t> no_rejected {0};
+
+        std::mutex class_mutx;
+    };
+
+    struct context
+    {
+        // class in which the request took a slot, if any
+        route_class* admitted {nullptr};
+    };
+
+    // decoding outputs, proving, checking and pushing txs,
+    // searching and txs with ring signatures, i.e., /tx/<hash>/1
+    route_class heavy_routes;
+
+    // all other routes, by default without a limit
+    route_class default_routes;
+
+    AdmissionControl()
+    {
+        heavy_routes.name   = "heavy";
+        default_routes.name = "default";
+    }
+
+    void
+    set_limits(route_class& rc, size_t max_concurrent)
+    {
+        std::lock_guard<std::mutex> lck (rc.class_mutx);
+
+        rc.max_concurrent = max_concurrent;
+    }
+
+    // also used by RateLimiter, to give heavy routes higher cost
+    static bool
+    is_heavy_route(string const& url)
+    {
+        static const vector<string> heavy_prefixes {
+                "/myoutputs", "/prove", "/checkandpush",
+                "/checkrawkeyimgs", "/checkrawoutputkeys",
+                "/ringmemberstxhex", "/blockhexcomplete",
+                "/search", "/api/search",
+                "/api/outputs", "/api/detailedtransaction"};
+
+        static const regex tx_with_ring_sigs {"^/tx/[^/]+/[1-9]"};
+
+        for (string const& prefix: heavy_prefixes)
+            if (url.compare(0, prefix.size(), prefix) == 0)
+                return true;
+
+        return regex_search(url, tx_with_ring_sigs);
+    }
+
+    route_class&
+    classify(crow::request const& req)
+    {
+        return is_heavy_route(req.url) ? heavy_routes : default_routes;
+    }
+
+    void
+    before_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        // websocket upgrades never get to after_handle,
+        // so they must not take a slot
+        if (req.upgrade)
+            return;
+
+        route_class& rc = classify(req);
+
+        std::unique_lock<std::mutex> lck (rc.class_mutx);
+
+        if (rc.max_concurrent > 0 && rc.no_active >= rc.max_concurrent)
+        {
+            lck.unlock();
+            reject(rc, res);
+            return;
+        }
+
+        ++rc.no_active;
+
+        lck.unlock();
+
+        ctx.admitted = &rc;
+
+        ++rc.no_admitted;
+    }
+
+    void
+    after_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        if (!ctx.admitted)
+            return;
+
+        route_class& rc = *ctx.admitted;
+
+        {
+            std::lock_guard<std::mutex> lck (rc.class_mutx);
+            --rc.no_active;
+        }
+
+        ctx.admitted = nullptr;
+    }
+
+private:
+
+    void
+    reject(route_class& rc, crow::response& res)
+    {
+        ++rc.no_rejected;
+
+        res.code = 503;
+        res.set_header("Retry-After", "1");
+        res.set_header("Content-Type", "text/plain");
+        res.body = "Server is busy. Please try again later.";
+        res.end();
+    }
+};
+
+}
+
+#endif //XMRBLOCKS_ADMISSIONCONTROL_H
@@ -0,0 +1,360 @@
+//
+// Created on 18/10/26.
+//
+
+#include "ChainNotifier.h"
+#include "Metrics.h"
+
+namespace xmreg
+{
+
+using namespace std;
+
+namespace local = boost::asio::local;
+
+
+void
+ChainNotifier::set_blockchain_variables(Blockchain* _core_storage)
+{
+    core_storage = _core_storage;
+}
+
+void
+ChainNotifier::start_notifier_thread()
+{
+    min_poll_interval = std::max<uint64_t>(1, min_poll_interval);
+    max_poll_interval = std::max<uint64_t>(min_poll_interval, max_poll_interval);
+
+    if (is_running)
+        return;
+
+    fingerprint initial_fp;
+
+    if (!read_fingerprint(initial_fp))
+    {
+        cerr << "Cant read initial blockchain fingerprint. "
+             << "Change detection is not started." << endl;
+        return;
+    }
+
+    m_thread = boost::thread{[initial_fp]()
+    {
+        boost::asio::io_context io;
+
+        std::unique_ptr<local::datagram_protocol::socket> notify_socket;
+
+        array<char, 256> recv_buffer;
+        local::datagram_protocol::endpoint sender;
+
+        // set by the socket when any datagram arrives
+        bool notified {false};
+
+        // set when receiving fails. The socket is then dropped, as
+        // without a pending receive the io_context has no work and
+        // run_one_for would return at once, i.e., we would busy loop.
+        bool socket_failed {false};
+
+        std::function<void()> start_receive = [&]()
+        {
+            notify_socket->async_receive_from(
+                boost::asio::buffer(recv_buffer), sender,
+                [&](boost::system::error_code const& ec, size_t)
+                {
+                    if (ec)
+                    {
+                        if (ec != boost::asio::error::operation_aborted)
+                        {
+                            cerr << "Cant receive notifications on "
+                                 << notify_socket_path << ": " << ec.message()
+                                 << "\nOnly lmdb polling will be used." << endl;
+                        }
+
+                        socket_failed = true;
+                        return;
+                    }
+
+                    notified = true;
+                    start_receive();
+                });
+        };
+
+        if (!notify_socket_path.empty())
+        {
+            try
+            {
+                boost::filesystem::file_status socket_status
+                        = boost::filesystem::symlink_status(notify_socket_path);
+
+                // remove left overs from previous runs, but
+                // nothing else which could be at the given path
+                if (socket_status.type() == boost::filesystem::socket_file)
+                {
+                    boost::filesystem::remove(notify_socket_path);
+                }
+                else if (boost::filesystem::exists(socket_status))
+                {
+                    throw std::runtime_error(
+                            "path exists and is not a socket");
+                }
+
+                notify_socket = std::make_unique<local::datagram_protocol::socket>(
+                        io, local::datagram_protocol::endpoint(notify_socket_path));
+
+                start_receive();
+
+                cout << "Listening for notifications on "
+                     << notify_socket_path << endl;
+            }
+            catch (std::exception const& e)
+            {
+                cerr << "Cant open notification socket " << notify_socket_path
+                     << ": " << e.what() << "\nOnly lmdb polling will be used."
+                     << endl;
+
+                notify_socket.reset();
+            }
+        }
+
+        fingerprint last_fp = initial_fp;
+
+        uint64_t poll_interval = min_poll_interval;
+
+        auto txpool_xor_read_time = boost::chrono::steady_clock::now();
+
+        try
+        {
+            while (true)
+            {
+                boost::this_thread::interruption_point();
+
+                if (notify_socket && socket_failed)
+                {
+                    boost::system::error_code ec;
+                    notify_socket->close(ec);
+                    notify_socket.reset();
+                    boost::filesystem::remove(notify_socket_path, ec);
+                }
+
+                if (notify_socket)
+                {
+                    if (io.stopped())
+                        io.restart();
+
+                    // wait for the poll interval or until
+                    // some notification arrives, whichever is first.
+                    io.run_one_for(std::chrono::milliseconds(poll_interval));
+                }
+                else
+                {
+                    boost::this_thread::sleep_for(
+                            boost::chrono::milliseconds(poll_interval));
+                }
+
+                // first check only things which are O(1) to read
+                fingerprint current_fp;
+
+                if (!read_fingerprint(current_fp, false))
+                {
+                    poll_interval = max_poll_interval;
+                    continue;
+                }
+
+                bool chain_changed
+                        = current_fp.height != last_fp.height
+                          || current_fp.top_block_hash != last_fp.top_block_hash;
+
+                auto now = boost::chrono::steady_clock::now();
+
+                if (chain_changed || notified
+                        || now - txpool_xor_read_time
+                           >= boost::chrono::milliseconds(max_poll_interval))
+                {
+                    if (!read_fingerprint(current_fp))
+                    {
+                        poll_interval = max_poll_interval;
+                        continue;
+                    }
+
+                    txpool_xor_read_time = now;
+                }
+                else
+                {
+                    // txpool changes which keep its count are
+                    // found with the next walk over it
+                    current_fp.txpool_xor = last_fp.txpool_xor;
+                }
+
+                bool mempool_changed
+                        = current_fp.txpool_count != last_fp.txpool_count
+                          || current_fp.txpool_xor != last_fp.txpool_xor;
+
+                last_fp = current_fp;
+
+                if (chain_changed || mempool_changed)
+                {
+                    {
+                        boost::lock_guard<boost::mutex> lck (change_mutx);
+
+                        if (chain_changed)
+                            ++chain_version;
+
+                        if (mempool_changed)
+                            ++mempool_version;
+                    }
+
+                    change_cv.notify_all();
+
+                    poll_interval = min_poll_interval;
+                }
+                else if (notified)
+                {
+                    // daemon told us something happened, but
+                    // lmdb does not show it yet. So check again soon.
+                    poll_interval = min_poll_interval;
+                }
+                else
+                {
+                    poll_interval = std::min(poll_interval * 2,
+                                             max_poll_interval);
+                }
+
+                notified = false;
+
+            } // while (true)
+        }
+        catch (boost::thread_interrupted&)
+        {
+            if (notify_socket)
+            {
+                boost::system::error_code ec;
+                notify_socket->close(ec);
+                boost::filesystem::remove(notify_socket_path, ec);
+            }
+
+            cout << "Change detection thread interrupted." << endl;
+            return;
+        }
+
+    }}; //  m_thread = boost::thread{[]()
+
+    is_running = true;
+}
+
+void
+ChainNotifier::stop_notifier_thread()
+{
+    if (!is_running)
+        return;
+
+    // wake up everyone who waits for changes, so that they
+    // dont wait for the notifier anymore.
+    is_running = false;
+
+    change_cv.notify_all();
+
+    m_thread.interrupt();
+    m_thread.join();
+}
+
+bool
+ChainNotifier::read_fingerprint(fingerprint& fp, bool with_txpool_xor)
+{
+    fp = fingerprint {};
+
+    try
+    {
+        BlockchainDB& db = core_storage->get_db();
+
+        fp.height         = db.height();
+        fp.top_block_hash = db.top_block_hash();
+
+        if (!with_txpool_xor)
+        {
+            fp.txpool_count = db.get_txpool_tx_count(relay_category::all);
+            return true;
+        }
+
+        static Metrics::counter& reads
+                = Metrics::lmdb_reads.get("for_all_txpool_txes");
+
+        reads.inc();
+
+        // we dont read tx blobs, only their hashes
+        db.for_all_txpool_txes(
+            [&fp](crypto::hash const& txid,
+                  txpool_tx_meta_t const&,
+                  cryptonote::blobdata_ref const*)
+            {
+                ++fp.txpool_count;
+
+                for (size_t i = 0; i < sizeof(txid.data); ++i)
+                    fp.txpool_xor.data[i] ^= txid.data[i];
+
+                return true;
+            }, false, relay_category::all);
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant read blockchain fingerprint: " << e.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ChainNotifier::wait_for_chain_change(uint64_t& last_version,
+                                     boost::chrono::milliseconds max_wait)
+{
+    return wait_for_change(chain_version, last_version, max_wait);
+}
+
+bool
+ChainNotifier::wait_for_mempool_change(uint64_t& last_version,
+                                       boost::chrono::milliseconds max_wait)
+{
+    return wait_for_change(mempool_version, last_version, max_wait);
+}
+
+bool
+ChainNotifier::wait_for_change(atomic<uint64_t> const& version,
+                               uint64_t& last_version,
+                               boost::chrono::milliseconds max_wait)
+{
+    if (!is_running)
+    {
+        boost::this_thread::sleep_for(max_wait);
+        return false;
+    }
+
+    boost::unique_lock<boost::mutex> lck (change_mutx);
+
+    bool changed = change_cv.wait_for(lck, max_wait, [&]()
+    {
+        return version != last_version || !is_running;
+    });
+
+    changed = changed && version != last_version;
+
+    last_version = version;
+
+    return changed;
+}
+
+bool
+ChainNotifier::is_thread_running()
+{
+    return is_running;
+}
+
+uint64_t           ChainNotifier::min_poll_interval {250};
+uint64_t           ChainNotifier::max_poll_interval {5000};
+string             ChainNotifier::notify_socket_path {};
+atomic<uint64_t>   ChainNotifier::chain_version {0};
+atomic<uint64_t>   ChainNotifier::mempool_version {0};
+boost::thread      ChainNotifier::m_thread;
+atomic<bool>       ChainNotifier::is_running {false};
+boost::mutex       ChainNotifier::change_mutx;
+boost::condition_variable ChainNotifier::change_cv;
+Blockchain*        ChainNotifier::core_storage {nullptr};
+}
@@ -0,0 +1,125 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_CHAINNOTIFIER_H
+#define XMRBLOCKS_CHAINNOTIFIER_H
+
+#include "MicroCore.h"
+
+#include <boost/thread.hpp>
+#include <boost/asio.hpp>
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Detects changes of the blockchain and of the mempool and
+ * wakes up threads waiting for them, i.e., MempoolStatus and
+ * CurrentBlockchainStatus threads, so that they dont need
+ * to poll in fixed intervals.
+ *
+ * Changes are detected using a cheap fingerprint of the lmdb
+ * (current height, top block hash and number of txpool txs).
+ * The fingerprint is checked with adaptive backoff: often when
+ * things change, less and less often when nothing happens.
+ *
+ * Txs which arrive and leave the txpool in equal numbers do not
+ * change its count, so xor of txpool tx hashes is also part of
+ * the fingerprint. As it takes a walk over the whole txpool,
+ * it is read only when a new block arrives, when notified,
+ * and otherwise at most once per max_poll_interval.
+ *
+ * Optionally, a local unix datagram socket can be opened
+ * so that the daemon (e.g., through monerod's --block-notify)
+ * or xmrblocks-notify can tell us that something happened.
+ * Any datagram received makes us to check the
+ * fingerprint immediately.
+ */
+struct ChainNotifier
+{
+    struct fingerprint
+    {
+        uint64_t height {0};
+        crypto::hash top_block_hash {crypto::null_hash};
+        uint64_t txpool_count {0};
+        crypto::hash txpool_xor {crypto::null_hash};
+    };
+
+    // when fingerprint changes, we check again after
+    // min_poll_interval. Each check without change doubles
+    // the interval up to max_poll_interval. Values in milliseconds.
+    static uint64_t min_poll_interval;
+    static uint64_t max_poll_interval;
+
+    // path of unix datagram socket for notifications.
+    // empty means no socket.
+    static string notify_socket_path;
+
+    // incremented whenever a new block or a change
+    // in the mempool is detected
+    static atomic<uint64_t> chain_version;
+    static atomic<uint64_t> mempool_version;
+
+    static boost::thread m_thread;
+
+    static atomic<bool> is_running;
+
+    static boost::mutex change_mutx;
+    static boost::condition_variable change_cv;
+
+    static Blockchain* core_storage;
+
+    static void
+    set_blockchain_variables(Blockchain* _core_storage);
+
+    static void
+    start_notifier_thread();
+
+    static void
+    stop_notifier_thread();
+
+    // txpool_xor is read only if with_txpool_xor is true
+    static bool
+    read_fingerprint(fingerprint& fp, bool with_txpool_xor = true);
+
+    /**
+     * Waits until chain_version is different than last_version
+     * or max_wait passes. If the notifier thread is not running,
+     * this just sleeps for max_wait, i.e., we fall back to
+     * fixed interval polling.
+     *
+     * last_version is updated to the current chain_version.
+     * Returns true if a change was detected.
+     *
+     * This is boost thread interruption point.
+     */
+    static bool
+    wait_for_chain_change(uint64_t& last_version,
+                          boost::chrono::milliseconds max_wait);
+
+    static bool
+    wait_for_mempool_change(uint64_t& last_version,
+                            boost::chrono::milliseconds max_wait);
+
+    static bool
+    is_thread_running();
+
+private:
+
+    static bool
+    wait_for_change(atomic<uint64_t> const& version,
+                    uint64_t& last_version,
+                    boost::chrono::milliseconds max_wait);
+};
+
+}
+
+#endif //XMRBLOCKS_CHAINNOTIFIER_H
@@ -0,0 +1,581 @@
+//
+// Created on 18/10/26.
+//
+
+#include "ChainStats.h"
+#include "Metrics.h"
+
+#include <fstream>
+
+namespace xmreg
+{
+
+using namespace std;
+
+using Guard = std::lock_guard<std::mutex>;
+
+namespace
+{
+
+// first bytes of chain_stats.bin. Change it when
+// the layout of the saved structs changes.
+constexpr char chain_stats_magic[8] {'X', 'M', 'R', 'C', 'H', 'S', '0', '1'};
+
+template <typename POD>
+void
+write_pod(std::ofstream& out, POD const& pod)
+{
+    out.write(reinterpret_cast<char const*>(&pod), sizeof(POD));
+}
+
+template <typename POD>
+bool
+read_pod(std::ifstream& in, POD& pod)
+{
+    in.read(reinterpret_cast<char*>(&pod), sizeof(POD));
+    return static_cast<bool>(in);
+}
+
+void
+write_series(std::ofstream& out, ChainStats::series const& buckets)
+{
+    write_pod(out, static_cast<uint64_t>(buckets.size()));
+
+    for (auto const& ts_bucket: buckets)
+    {
+        write_pod(out, ts_bucket.first);
+        write_pod(out, ts_bucket.second);
+    }
+}
+
+bool
+read_series(std::ifstream& in, ChainStats::series& buckets)
+{
+    uint64_t no_of_buckets {0};
+
+    if (!read_pod(in, no_of_buckets))
+        return false;
+
+    for (uint64_t i = 0; i < no_of_buckets; ++i)
+    {
+        uint64_t timestamp;
+        ChainStats::bucket blk_bucket;
+
+        if (!read_pod(in, timestamp) || !read_pod(in, blk_bucket))
+            return false;
+
+        buckets.emplace_hint(buckets.end(), timestamp, blk_bucket);
+    }
+
+    return true;
+}
+
+}
+
+void
+ChainStats::bucket::add(block_stats const& blk_stats)
+{
+    ++no_blocks;
+    no_txs     += blk_stats.no_txs;
+    fee        += blk_stats.fee;
+    weight     += blk_stats.weight;
+    no_inputs  += blk_stats.no_inputs;
+    no_outputs += blk_stats.no_outputs;
+
+    for (size_t i = 0; i < no_of_rct_types; ++i)
+        rct_types[i] += blk_stats.rct_types[i];
+}
+
+void
+ChainStats::bucket::remove(block_stats const& blk_stats)
+{
+    --no_blocks;
+    no_txs     -= blk_stats.no_txs;
+    fee        -= blk_stats.fee;
+    weight     -= blk_stats.weight;
+    no_inputs  -= blk_stats.no_inputs;
+    no_outputs -= blk_stats.no_outputs;
+
+    for (size_t i = 0; i < no_of_rct_types; ++i)
+        rct_types[i] -= blk_stats.rct_types[i];
+}
+
+void
+ChainStats::set_blockchain_variables(MicroCore* _mcore,
+                                     Blockchain* _core_storage)
+{
+    mcore = _mcore;
+    core_storage =_core_storage;
+}
+
+void
+ChainStats::start_chain_stats_thread()
+{
+    if (is_running)
+        return;
+
+    chain_series stats;
+
+    if (bf::exists(get_output_file_path()) && !load_chain_stats(stats))
+    {
+        cerr << "Chain stats file cant be read: " << get_output_file_path()
+             << "\nStarting chain stats from scratch." << endl;
+
+        stats = chain_series {};
+        recent_blocks.clear();
+    }
+
+    publish_snapshot(stats);
+
+    m_thread = boost::thread{[stats]() mutable
+    {
+        try
+        {
+            uint64_t chain_version {ChainNotifier::chain_version};
+
+            while (true)
+            {
+                boost::this_thread::interruption_point();
+
+                uint64_t current_height
+                        = core_storage->get_current_blockchain_height();
+
+                bool changed = remove_orphaned_blocks(stats, current_height);
+
+                uint64_t previous_height = stats.height;
+
+                if (stats.height < current_height)
+                {
+                    if (!update_chain_stats(stats, current_height))
+                    {
+                        // try again later
+                        boost::this_thread::sleep_for(
+                                boost::chrono::seconds(10));
+                        continue;
+                    }
+                }
+
+                changed = changed || stats.height != previous_height;
+
+                if (changed)
+                {
+                    save_chain_stats(stats);
+                    publish_snapshot(stats);
+                }
+
+                // if we are far behind, e.g., on the first start,
+                // continue with next chunks. Otherwise wait for new block
+                // or a minute if ChainNotifier is not running.
+                if (stats.height < current_height)
+                {
+                    cout << "chain stats calculated up to block: "
+                         << stats.height << endl;
+                    continue;
+                }
+
+                ChainNotifier::wait_for_chain_change(
+                        chain_version, boost::chrono::seconds(60));
+
+            } // while (true)
+        }
+        catch (boost::thread_interrupted&)
+        {
+            cout << "Chain stats thread interrupted." << endl;
+            return;
+        }
+
+    }}; //  m_thread = boost::thread{[]()
+
+    is_running = true;
+}
+
+bool
+ChainStats::update_chain_stats(chain_series& stats, uint64_t current_height)
+{
+    uint64_t no_of_threads = catchup_threads > 0
+                             ? catchup_threads
+                             : std::max(1u, std::thread::hardware_concurrency());
+
+    vector<vector<block_stats>> chunks;
+    vector<std::future<bool>> chunk_ftrs;
+
+    chunks.reserve(no_of_threads);
+
+    uint64_t chunk_start = stats.height;
+
+    while (chunks.size() < no_of_threads && chunk_start < current_height)
+    {
+        uint64_t chunk_end = std::min(chunk_start + blockchain_chunk_size,
+                                      current_height);
+
+        chunks.emplace_back();
+
+        chunk_ftrs.push_back(std::async(std::launch::async,
+                                        calculate_block_stats,
+                                        chunk_start, chunk_end,
+                                        std::ref(chunks.back())));
+
+        chunk_start = chunk_end;
+    }
+
+    // chunks are consecutive, so they are folded
+    // in order, as if read by one thread
+    for (size_t i = 0; i < chunk_ftrs.size(); ++i)
+    {
+        if (!chunk_ftrs[i].get())
+            return false;
+
+        for (block_stats const& blk_stats: chunks[i])
+            fold_block(stats, blk_stats);
+    }
+
+    return true;
+}
+
+bool
+ChainStats::calculate_block_stats(uint64_t start_blk, uint64_t end_blk,
+                                  vector<block_stats>& blocks)
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    blocks.reserve(end_blk - start_blk);
+
+    try
+    {
+        for (uint64_t height = start_blk; height < end_blk; ++height)
+        {
+            block blk;
+
+            if (!mcore->get_block_by_height(height, blk))
+                return false;
+
+            block_stats blk_stats;
+
+            blk_stats.height    = height;
+            blk_stats.blk_hash  = db.get_block_hash_from_height(height);
+            blk_stats.timestamp = blk.timestamp;
+            blk_stats.weight    = db.get_block_weight(height);
+            blk_stats.no_txs    = blk.tx_hashes.size();
+
+            for (crypto::hash const& tx_hash: blk.tx_hashes)
+            {
+                // we need only tx prefix and rct type and fee,
+                // so prunable part, i.e., ring signatures
+                // and range proofs, is not read
+                cryptonote::blobdata tx_blob;
+
+                static Metrics::counter& reads
+                        = Metrics::lmdb_reads.get("get_pruned_tx_blob");
+
+                reads.inc();
+
+                if (!db.get_pruned_tx_blob(tx_hash, tx_blob))
+                {
+                    cerr << "Cant get tx " << pod_to_hex(tx_hash) << endl;
+                    return false;
+                }
+
+                transaction tx;
+
+                if (!parse_and_validate_tx_base_from_blob(tx_blob, tx))
+                {
+                    cerr << "Cant parse tx " << pod_to_hex(tx_hash) << endl;
+                    return false;
+                }
+
+                blk_stats.fee        += get_tx_fee(tx);
+                blk_stats.no_inputs  += tx.vin.size();
+                blk_stats.no_outputs += tx.vout.size();
+
+                size_t rct_type = tx.version == 1
+                                  ? rct::RCTTypeNull
+                                  : tx.rct_signatures.type;
+
+                if (rct_type < no_of_rct_types)
+                    ++blk_stats.rct_types[rct_type];
+            }
+
+            blocks.push_back(blk_stats);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant calculate chain stats of blocks " << start_blk
+             << " - " << end_blk << ": " << e.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+void
+ChainStats::fold_block(chain_series& stats, block_stats const& blk_stats)
+{
+    stats.days[day_start(blk_stats.timestamp)].add(blk_stats);
+    stats.weeks[week_start(blk_stats.timestamp)].add(blk_stats);
+
+    stats.height = blk_stats.height + 1;
+
+    recent_blocks.push_back(blk_stats);
+
+    if (recent_blocks.size() > max_reorg_depth)
+        recent_blocks.pop_front();
+}
+
+bool
+ChainStats::remove_orphaned_blocks(chain_series& stats, uint64_t current_height)
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    bool removed {false};
+
+    while (!recent_blocks.empty())
+    {
+        block_stats const& last_blk = recent_blocks.back();
+
+        try
+        {
+            if (last_blk.height < current_height
+                    && db.get_block_hash_from_height(last_blk.height)
+                       == last_blk.blk_hash)
+            {
+                break;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant get hash of block " << last_blk.height
+                 << ": " << e.what() << endl;
+            return removed;
+        }
+
+        for (series* buckets: {&stats.days, &stats.weeks})
+        {
+            uint64_t bucket_start = buckets == &stats.days
+                                    ? day_start(last_blk.timestamp)
+                                    : week_start(last_blk.timestamp);
+
+            auto it = buckets->find(bucket_start);
+
+            if (it == buckets->end())
+                continue;
+
+            it->second.remove(last_blk);
+
+            if (it->second.no_blocks == 0)
+                buckets->erase(it);
+        }
+
+        stats.height = last_blk.height;
+
+        recent_blocks.pop_back();
+
+        removed = true;
+    }
+
+    if (removed && recent_blocks.empty() && stats.height > 0)
+    {
+        cerr << "Blockchain reorganization deeper than "
+             << max_reorg_depth << " blocks. "
+             << "Calculating chain stats from scratch." << endl;
+
+        stats = chain_series {};
+    }
+
+    return removed;
+}
+
+bool
+ChainStats::save_chain_stats(chain_series const& stats)
+{
+    bf::path stats_file_path = get_output_file_path();
+
+    // write new file and rename it, so that
+    // we never end up with half written file
+    bf::path tmp_file_path = stats_file_path;
+    tmp_file_path += ".tmp";
+
+    {
+        std::ofstream out {tmp_file_path.string(), std::ios::binary};
+
+        if (!out)
+        {
+            cerr << "Cant open " << tmp_file_path << endl;
+            return false;
+        }
+
+        out.write(chain_stats_magic, sizeof(chain_stats_magic));
+
+        write_pod(out, stats.height);
+
+        write_series(out, stats.days);
+        write_series(out, stats.weeks);
+
+        write_pod(out, static_cast<uint64_t>(recent_blocks.size()));
+
+        for (block_stats const& blk_stats: recent_blocks)
+            write_pod(out, blk_stats);
+
+        out.flush();
+
+        if (!out)
+        {
+            cerr << "Cant write " << tmp_file_path << endl;
+            return false;
+        }
+    }
+
+    boost::system::error_code ec;
+
+    bf::rename(tmp_file_path, stats_file_path, ec);
+
+    if (ec)
+    {
+        cerr << "Cant rename " << tmp_file_path << ": " << ec.message() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ChainStats::load_chain_stats(chain_series& stats)
+{
+    std::ifstream in {get_output_file_path().string(), std::ios::binary};
+
+    if (!in)
+        return false;
+
+    char magic[sizeof(chain_stats_magic)];
+
+    in.read(magic, sizeof(magic));
+
+    if (!in || !std::equal(std::begin(magic), std::end(magic),
+                           std::begin(chain_stats_magic)))
+    {
+        cerr << "Chain stats file has incorrect format" << endl;
+        return false;
+    }
+
+    stats = chain_series {};
+    recent_blocks.clear();
+
+    uint64_t no_of_recent_blocks {0};
+
+    if (!read_pod(in, stats.height)
+            || !read_series(in, stats.days)
+            || !read_series(in, stats.weeks)
+            || !read_pod(in, no_of_recent_blocks))
+    {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < no_of_recent_blocks; ++i)
+    {
+        block_stats blk_stats;
+
+        if (!read_pod(in, blk_stats))
+            return false;
+
+        recent_blocks.push_back(blk_stats);
+    }
+
+    return true;
+}
+
+void
+ChainStats::publish_snapshot(chain_series const& stats)
+{
+    auto new_snapshot = std::make_shared<stats_snapshot>();
+
+    new_snapshot->data = stats;
+
+    Guard lck (stats_mutx);
+
+    new_snapshot->version = current_snapshot->version + 1;
+
+    current_snapshot = std::move(new_snapshot);
+}
+
+ChainStats::stats_snapshot_ptr
+ChainStats::get_stats_snapshot()
+{
+    Guard lck (stats_mutx);
+    return current_snapshot;
+}
+
+shared_ptr<const string>
+ChainStats::stats_snapshot::get_render(string const& key) const
+{
+    Guard lck (renders_mutx);
+
+    auto it = renders.find(key);
+
+    if (it == renders.end())
+        return nullptr;
+
+    return it->second;
+}
+
+shared_ptr<const string>
+ChainStats::stats_snapshot::add_render(string const& key,
+                                       string&& rendered) const
+{
+    auto rendered_ptr = std::make_shared<const string>(std::move(rendered));
+
+    Guard lck (renders_mutx);
+
+    // if other request rendered it in the meantime,
+    // keep the first one
+    return renders.emplace(key, rendered_ptr).first->second;
+}
+
+uint64_t
+ChainStats::day_start(uint64_t timestamp)
+{
+    return timestamp - timestamp % 86400;
+}
+
+uint64_t
+ChainStats::week_start(uint64_t timestamp)
+{
+    // 1 Jan 1970 was thursday, so weeks
+    // from monday are 3 days behind
+    uint64_t days = timestamp / 86400 + 3;
+
+    return days < 7 ? 0 : (days - days % 7 - 3) * 86400;
+}
+
+bf::path
+ChainStats::get_output_file_path()
+{
+    return blockchain_path / output_file;
+}
+
+bool
+ChainStats::is_thread_running()
+{
+    return is_running;
+}
+
+bf::path ChainStats::blockchain_path {"/home/mwo/.bitmonero/lmdb"};
+
+string ChainStats::output_file {"chain_stats.bin"};
+
+uint64_t ChainStats::blockchain_chunk_size {1000};
+
+uint64_t ChainStats::catchup_threads {0};
+
+boost::thread ChainStats::m_thread;
+
+atomic<bool> ChainStats::is_running {false};
+
+mutex ChainStats::stats_mutx;
+
+ChainStats::stats_snapshot_ptr ChainStats::current_snapshot {std::make_shared<ChainStats::stats_snapshot>()};
+
+deque<ChainStats::block_stats> ChainStats::recent_blocks;
+
+Blockchain* ChainStats::core_storage {nullptr};
+MicroCore*  ChainStats::mcore {nullptr};
+}
@@ -0,0 +1,198 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_CHAINSTATS_H
+#define XMRBLOCKS_CHAINSTATS_H
+
+#include "MicroCore.h"
+#include "ChainNotifier.h"
+
+#include <boost/thread.hpp>
+
+#include <iostream>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace std;
+
+namespace bf = boost::filesystem;
+
+/**
+ * Daily and weekly aggregates of the blockchain, e.g.,
+ * number of txs, fees, block weights, inputs and outputs,
+ * and how many txs of each RingCT type there were.
+ *
+ * A background thread folds every new block into its day
+ * and week buckets, so that charts over the whole blockchain
+ * can be served from memory instead of reading thousands
+ * of blocks.
+ *
+ * Contributions of the last max_reorg_depth blocks are kept,
+ * so that blocks orphaned by a reorganization can be taken out
+ * of their buckets. Everything is saved in
+ * <blockchain_path>/chain_stats.bin, so we continue from
+ * the last block after restart.
+ */
+struct ChainStats
+{
+    // from RCTTypeNull (v1 txs) to RCTTypeBulletproofPlus
+    static constexpr size_t no_of_rct_types {7};
+
+    // what a single block adds to its buckets
+    struct block_stats
+    {
+        uint64_t height {0};
+        crypto::hash blk_hash {crypto::null_hash};
+        uint64_t timestamp {0};
+        uint64_t no_txs {0};        // without coinbase tx
+        uint64_t fee {0};
+        uint64_t weight {0};
+        uint64_t no_inputs {0};
+        uint64_t no_outputs {0};
+        array<uint64_t, no_of_rct_types> rct_types {};
+    };
+
+    struct bucket
+    {
+        uint64_t no_blocks {0};
+        uint64_t no_txs {0};
+        uint64_t fee {0};
+        uint64_t weight {0};
+        uint64_t no_inputs {0};
+        uint64_t no_outputs {0};
+        array<uint64_t, no_of_rct_types> rct_types {};
+
+        void
+        add(block_stats const& blk_stats);
+
+        void
+        remove(block_stats const& blk_stats);
+    };
+
+    // buckets by their start timestamp (utc)
+    using series = map<uint64_t, bucket>;
+
+    struct chain_series
+    {
+        // height of the next block to be folded
+        uint64_t height {0};
+
+        series days;
+        series weeks;
+    };
+
+    // Published state of the aggregates. Like mempool snapshots,
+    // it never changes once published, so its json renders
+    // are memoized in it.
+    struct stats_snapshot
+    {
+        uint64_t version {0};
+
+        chain_series data;
+
+        shared_ptr<const string>
+        get_render(string const& key) const;
+
+        shared_ptr<const string>
+        add_render(string const& key, string&& rendered) const;
+
+    private:
+
+        mutable mutex renders_mutx;
+
+        mutable unordered_map<string, shared_ptr<const string>> renders;
+    };
+
+    using stats_snapshot_ptr = std::shared_ptr<const stats_snapshot>;
+
+    // deeper reorganizations than this make us start from scratch
+    static constexpr uint64_t max_reorg_depth {720};
+
+    static bf::path blockchain_path;
+
+    static string output_file;
+
+    // how many blocks a single thread reads at once
+    static uint64_t blockchain_chunk_size;
+
+    // 0 means based on the cpu
+    static uint64_t catchup_threads;
+
+    static boost::thread m_thread;
+
+    static atomic<bool> is_running;
+
+    static mutex stats_mutx;
+
+    static stats_snapshot_ptr current_snapshot;
+
+    // last folded blocks, newest at the back.
+    // Used only by the thread.
+    static deque<block_stats> recent_blocks;
+
+    static MicroCore* mcore;
+    static Blockchain* core_storage;
+
+    static void
+    set_blockchain_variables(MicroCore* _mcore,
+                             Blockchain* _core_storage);
+
+    static void
+    start_chain_stats_thread();
+
+    // folds the next blocks, up to one chunk per thread,
+    // into stats. Returns false if something failed.
+    static bool
+    update_chain_stats(chain_series& stats, uint64_t current_height);
+
+    static bool
+    calculate_block_stats(uint64_t start_blk, uint64_t end_blk,
+                          vector<block_stats>& blocks);
+
+    static void
+    fold_block(chain_series& stats, block_stats const& blk_stats);
+
+    // takes blocks which are not in the blockchain
+    // anymore out of the buckets
+    static bool
+    remove_orphaned_blocks(chain_series& stats, uint64_t current_height);
+
+    static bool
+    save_chain_stats(chain_series const& stats);
+
+    static bool
+    load_chain_stats(chain_series& stats);
+
+    static void
+    publish_snapshot(chain_series const& stats);
+
+    static stats_snapshot_ptr
+    get_stats_snapshot();
+
+    // start of the utc day of the timestamp
+    static uint64_t
+    day_start(uint64_t timestamp);
+
+    // start of the utc week (from monday) of the timestamp
+    static uint64_t
+    week_start(uint64_t timestamp);
+
+    static bf::path
+    get_output_file_path();
+
+    static bool
+    is_thread_running();
+};
+
+}
+
+#endif //XMRBLOCKS_CHAINSTATS_H
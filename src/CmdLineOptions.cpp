@@ -43,12 +43,28 @@ namespace xmreg
                  "enable links to provide hex represtations of a tx and a block")
                 ("enable-autorefresh-option", value<bool>()->default_value(false)->implicit_value(true),
                  "enable users to have the index page on autorefresh")
+                ("enable-live-updates", value<bool>()->default_value(false)->implicit_value(true),
+                 "push new blocks and mempool txs to autorefresh pages over websocket, instead of reloading them. Implies --enable-autorefresh-option")
+                ("live-updates-max-viewers", value<size_t>()->default_value(1000),
+                 "maximum number of pages getting live updates at the same time. 0 means no limit")
+                ("enable-metrics", value<bool>()->default_value(false)->implicit_value(true),
+                 "enable /metrics with request, lmdb, daemon rpc and cache statistics in Prometheus text format")
                 ("enable-emission-monitor", value<bool>()->default_value(false)->implicit_value(true),
                  "enable Monero total emission monitoring thread")
+                ("enable-chain-stats", value<bool>()->default_value(false)->implicit_value(true),
+                 "enable daily and weekly chain statistics thread and api/chainstats")
+                ("emission-threads", value<size_t>()->default_value(0),
+                 "number of threads calculating emission when it is far behind the blockchain height, e.g., on the first start. Default is 0 which means it is based on the cpu")
                 ("port,p", value<string>()->default_value("8081"),
                  "default explorer port")
                 ("bindaddr,x", value<string>()->default_value("0.0.0.0"),
                  "default bind address for the explorer")
+                ("unix-socket", value<string>(),
+                 "path to unix domain socket on which to also handle http queries, e.g., from local nginx or tor hidden service")
+                ("unix-socket-mode", value<string>()->default_value("660"),
+                 "permissions, in octal, of the unix domain socket")
+                ("unix-socket-only", value<bool>()->default_value(false)->implicit_value(true),
+                 "handle http queries only on the unix domain socket, not on the port")
                 ("testnet-url", value<string>()->default_value(""),
                  "you can specify testnet url, if you run it on mainnet or stagenet. link will show on front page to testnet explorer")
                 ("stagenet-url", value<string>()->default_value(""),
@@ -60,9 +76,39 @@ namespace xmreg
                 ("mempool-info-timeout", value<string>()->default_value("5000"),
                  "maximum time, in milliseconds, to wait for mempool data for the front page")
                 ("mempool-refresh-time", value<string>()->default_value("5"),
-                 "time, in seconds, for each refresh of mempool state")
+                 "maximum time, in seconds, between refreshes of mempool state. Mempool is also refreshed as soon as a change in it is detected")
+                ("mempool-max-full-txs-size", value<string>()->default_value("32"),
+                 "maximum size, in MB, of blobs of the newest mempool txs kept fully parsed in memory. Older txs are parsed again from the mempool when needed, e.g., to decode outputs")
+                ("disable-change-detection", value<bool>()->default_value(false)->implicit_value(true),
+                 "disable detection of new blocks and mempool txs, and refresh mempool and emission in fixed time intervals instead")
+                ("change-poll-min-time", value<string>()->default_value("250"),
+                 "minimum time, in milliseconds, between checks of the blockchain and mempool for changes")
+                ("change-poll-max-time", value<string>()->default_value("5000"),
+                 "maximum time, in milliseconds, between checks of the blockchain and mempool for changes, when nothing happens")
+                ("notify-socket", value<string>(),
+                 "path to unix datagram socket on which to listen for new block and tx notifications, e.g., from xmrblocks-notify")
                 ("concurrency,c", value<size_t>()->default_value(0),
                  "number of threads handling http queries. Default is 0 which means it is based you on the cpu")
+                ("heavy-routes-concurrency", value<size_t>()->default_value(0),
+                 "maximum number of expensive queries, e.g., decoding outputs or showing ring signatures, handled at the same time. Queries over it get 503 response. Default is 0 which means compute-threads plus compute-queue, i.e., expensive queries wait in the compute queue and get 503 only when it is full. Lower values are raised to it")
+                ("rate-limit", value<size_t>()->default_value(0),
+                 "maximum number of queries per second from a single client. Queries over it get 429 response. Default is 0 which means no limit")
+                ("rate-limit-burst", value<size_t>()->default_value(0),
+                 "maximum number of queries a single client can make at once, above the rate limit. Default is 0 which means 5 seconds worth of queries")
+                ("rate-limit-heavy-cost", value<size_t>()->default_value(10),
+                 "how many cheap queries a single expensive query, e.g., decoding outputs or showing ring signatures, counts as in the rate limit")
+                ("trusted-proxies", value<string>(),
+                 "comma separated addresses of proxies, e.g., 127.0.0.1, whose X-Forwarded-For header is used to get client address for the rate limit")
+                ("compute-threads", value<size_t>()->default_value(0),
+                 "number of threads for expensive queries, e.g., decoding outputs, showing ring signatures or checking raw txs. Default is 0 which means it is based on the cpu")
+                ("compute-queue", value<size_t>()->default_value(64),
+                 "maximum number of expensive queries waiting for a compute thread. Queries over it get 503 response")
+                ("request-timeout", value<size_t>()->default_value(30000),
+                 "maximum time, in milliseconds, of expensive queries. Queries taking longer are stopped and show partial results or an error. 0 means no limit")
+                ("enable-server-timing", value<bool>()->default_value(false)->implicit_value(true),
+                 "send time spent reading lmdb, decoding, resolving rings, rendering, etc. in Server-Timing header of each response")
+                ("slow-request-time", value<size_t>()->default_value(0),
+                 "log queries taking longer than this, in milliseconds, with time spent in each of their phases. 0 means not logged")
                 ("bc-path,b", value<string>(),
                  "path to lmdb folder of the blockchain, e.g., ~/.bitmonero/lmdb")
                 ("ssl-crt-file", value<string>(),
@@ -73,6 +119,12 @@ namespace xmreg
                  "Specify username[:password] for daemon RPC client")
                 ("daemon-url,d", value<string>()->default_value("127.0.0.1:18081"),
                  "Monero daemon url")
+                ("daemon-rpc-connections", value<string>()->default_value("4"),
+                 "maximum number of concurrent connections to the daemon rpc")
+                ("daemon-rpc-timeout", value<string>()->default_value("15000"),
+                 "timeout, in milliseconds, of connections and calls to the daemon rpc")
+                ("daemon-rpc-cache-ttl", value<string>()->default_value("1000"),
+                 "time, in milliseconds, for which results of daemon rpc calls for network info, hard fork info and fee estimates are reused")
                 ("enable-mixin-guess", value<bool>()->default_value(false)->implicit_value(true),
                  "enable guessing real outputs in key images based on viewkey");
 
@@ -0,0 +1,280 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_COMPUTEEXECUTOR_H
+#define XMRBLOCKS_COMPUTEEXECUTOR_H
+
+#include "RequestDeadline.h"
+#include "RequestTimings.h"
+
+#include "../ext/crow_all.h"
+
+#include <boost/thread.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+namespace xmreg
+{
+
+using namespace std;
+
+#ifdef CROW_USE_BOOST
+namespace asio = boost::asio;
+#endif
+
+/**
+ * Pool of threads for expensive page handlers, e.g., resolving ring
+ * members, decoding outputs with viewkeys or checking raw txs.
+ *
+ * Crow's threads only parse requests and write responses. Handlers
+ * of expensive routes give their work to the executor with
+ * dispatch() and return at once. When the work is done, its
+ * response is posted back to the crow thread of the connection.
+ *
+ * When max_queued tasks already wait for a thread, new ones are
+ * rejected with 503, instead of piling up.
+ *
+ * Each request gets RequestDeadline::request_timeout from its dispatch.
+ * Requests which waited in the queue past it are not run at all.
+ * Their RequestTimings record, if any, goes with them, and gets
+ * the time they waited in the queue.
+ */
+class ComputeExecutor
+{
+public:
+
+    struct stats
+    {
+        size_t no_threads {0};
+        size_t max_queued {0};
+        size_t no_queued {0};
+        size_t no_active {0};
+        uint64_t no_completed {0};
+        uint64_t no_rejected {0};
+    };
+
+    ComputeExecutor() = default;
+
+    ComputeExecutor(ComputeExecutor const&) = delete;
+    ComputeExecutor& operator=(ComputeExecutor const&) = delete;
+
+    ~ComputeExecutor()
+    {
+        stop();
+    }
+
+    // 0 threads means based on the cpu
+    void
+    start(size_t _no_threads, size_t _max_queued)
+    {
+        no_threads = _no_threads > 0
+                     ? _no_threads
+                     : std::max(1u, boost::thread::hardware_concurrency());
+
+        max_queued = _max_queued;
+
+        for (size_t i = 0; i < no_threads; ++i)
+            threads.create_thread([this]() { run_tasks(); });
+    }
+
+    // finishes tasks in progress, queued ones are dropped
+    void
+    stop()
+    {
+        {
+            std::lock_guard<std::mutex> lck (tasks_mutx);
+
+            if (stopping)
+                return;
+
+            stopping = true;
+            tasks.clear();
+        }
+
+        tasks_cv.notify_all();
+
+        threads.join_all();
+    }
+
+    // false if the queue is full
+    bool
+    submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lck (tasks_mutx);
+
+            if (stopping || tasks.size() >= max_queued)
+            {
+                ++no_rejected;
+                return false;
+            }
+
+            tasks.push_back(std::move(task));
+        }
+
+        tasks_cv.notify_one();
+
+        return true;
+    }
+
+    /**
+     * Runs func, which returns crow::response, on the executor,
+     * and completes res with it on the crow thread of the request.
+     * Anything func uses must be captured by value, as the route
+     * handler returns before func runs.
+     */
+    template <typename Func>
+    void
+    dispatch(crow::request const& req, crow::response& res, Func func)
+    {
+        asio::io_context* io_context = req.io_context;
+
+        auto deadline = RequestDeadline::clock::time_point::max();
+
+        if (RequestDeadline::request_timeout > 0)
+        {
+            deadline = RequestDeadline::clock::now()
+                       + std::chrono::milliseconds {RequestDeadline::request_timeout};
+        }
+
+        // lives in the middleware context of the request,
+        // which is kept until res.end()
+        RequestTimings::record* timings = RequestTimings::current_record;
+
+        // the handler returns before the request ends, so the
+        // calling thread must not add its next requests'
+        // timings to this record.
+        RequestTimings::current_record = nullptr;
+
+        auto submitted = RequestTimings::clock::now();
+
+        bool queued = submit([&res, io_context, func, deadline,
+                              timings, submitted]()
+        {
+            crow::response result;
+
+            RequestDeadline::scope request_deadline {deadline};
+
+            RequestTimings::scope request_timings {timings};
+
+            if (timings)
+            {
+                timings->add(RequestTimings::queue,
+                             RequestTimings::clock::now() - submitted);
+            }
+
+            try
+            {
+                if (RequestDeadline::expired())
+                {
+                    result = crow::response(503,
+                            "Request took too long. Please try again later.");
+                }
+                else
+                {
+                    result = func();
+                }
+            }
+            catch (std::exception const& e)
+            {
+                cerr << "ComputeExecutor: " << e.what() << endl;
+                result = crow::response(500);
+            }
+
+            // connection, and thus res, are kept alive until res.end()
+            asio::post(*io_context,
+                       [&res, result = std::move(result)]() mutable
+            {
+                res = std::move(result);
+                res.end();
+            });
+        });
+
+        if (!queued)
+        {
+            res.code = 503;
+            res.set_header("Retry-After", "1");
+            res.set_header("Content-Type", "text/plain");
+            res.body = "Server is busy. Please try again later.";
+            res.end();
+        }
+    }
+
+    stats
+    get_stats()
+    {
+        std::lock_guard<std::mutex> lck (tasks_mutx);
+
+        stats s;
+
+        s.no_threads   = no_threads;
+        s.max_queued   = max_queued;
+        s.no_queued    = tasks.size();
+        s.no_active    = no_active;
+        s.no_completed = no_completed;
+        s.no_rejected  = no_rejected;
+
+        return s;
+    }
+
+private:
+
+    void
+    run_tasks()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lck (tasks_mutx);
+
+                tasks_cv.wait(lck, [this]()
+                {
+                    return stopping || !tasks.empty();
+                });
+
+                if (stopping)
+                    return;
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+
+                ++no_active;
+            }
+
+            task();
+
+            std::lock_guard<std::mutex> lck (tasks_mutx);
+
+            --no_active;
+            ++no_completed;
+        }
+    }
+
+    size_t no_threads {0};
+    size_t max_queued {0};
+
+    std::mutex tasks_mutx;
+    std::condition_variable tasks_cv;
+
+    deque<std::function<void()>> tasks;
+
+    bool stopping {false};
+
+    size_t no_active {0};
+    uint64_t no_completed {0};
+    uint64_t no_rejected {0};
+
+    boost::thread_group threads;
+};
+
+}
+
+#endif //XMRBLOCKS_COMPUTEEXECUTOR_H
@@ -25,25 +25,23 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
 {
     total_emission_atomic = Emission {0, 0, 0};
 
-    string emmision_saved_file = get_output_file_path().string();
+    bf::path emission_ledger_path = get_output_file_path();
 
-    // read stored emission data if possible
-    if (boost::filesystem::exists(emmision_saved_file))
+    // read stored emission data if possible, or start new ledger
+    if (!emission_ledger.open(emission_ledger_path))
     {
-        if (!load_current_emission_amount())
-        {
-            cerr << "Emission file cant be read, got corrupted or has incorrect format:\n " << emmision_saved_file
-                 << "\nEmission monitoring thread is not started.\nDelete the file and"
-                 << " restart the explorer or disable emission monitoring."
-                 << endl;
+        cerr << "Emission ledger cant be opened:\n " << emission_ledger_path
+             << "\nEmission monitoring thread is not started."
+             << endl;
 
-            cerr << "Press ENTER to continue without emission monitoring or Ctr+C to exit" << endl;
+        return;
+    }
 
-            cin.get();
+    EmissionLedger::record ledger_tip = emission_ledger.tip();
 
-            return;
-        }
-    }
+    total_emission_atomic = Emission {ledger_tip.coinbase,
+                                      ledger_tip.fee,
+                                      emission_ledger.size()};
 
     if (!is_running)
     {
@@ -51,21 +49,37 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
            {
                try
                {
+                   uint64_t chain_version {ChainNotifier::chain_version};
+
                    while (true)
                    {
+                       current_height = core_storage->get_current_blockchain_height();
+
+                       // blocks which were orphaned since the last time
+                       // or while the explorer was not running
+                       remove_orphaned_blocks();
+
                        Emission current_emission = total_emission_atomic;
 
-                       current_height = core_storage->get_current_blockchain_height();
+                       // if we are more than a chunk behind, e.g., on the first
+                       // start, catch up using all the cpu cores. Otherwise scan
+                       // 10000 blocks for emissiom or if we are at the top of
+                       // the blockchain, only new blocks
+                       if (current_emission.blk_no + blockchain_chunk_size
+                               < current_height)
+                       {
+                           catch_up_emission_amount();
+                       }
+                       else
+                       {
+                           update_current_emission_amount();
+                       }
 
-                       // scan 10000 blocks for emissiom or if we are at the top of
-                       // the blockchain, only few top blocks
-                       update_current_emission_amount();
+                       current_emission = total_emission_atomic;
 
                        cout << "current emission: " << string(current_emission) << endl;
 
-                       save_current_emission_amount();
-
-                       if (current_emission.blk_no < current_height - blockchain_chunk_size)
+                       if (current_emission.blk_no < current_height)
                        {
                            // while we scan the blockchain from scrach, every 10000
                            // blocks take 1 second break
@@ -74,8 +88,10 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
                        else
                        {
                            // when we reach top of the blockchain, update
-                           // the emission amount every minute.
-                           boost::this_thread::sleep_for(boost::chrono::seconds(60));
+                           // the emission amount when new block arrives,
+                           // or every minute if ChainNotifier is not running.
+                           ChainNotifier::wait_for_chain_change(
+                                   chain_version, boost::chrono::seconds(60));
                        }
 
                    } // while (true)
@@ -97,148 +113,250 @@ CurrentBlockchainStatus::start_monitor_blockchain_thread()
 void
 CurrentBlockchainStatus::update_current_emission_amount()
 {
-
     Emission current_emission = total_emission_atomic;
 
     uint64_t blk_no = current_emission.blk_no;
 
-    uint64_t end_block = blk_no + blockchain_chunk_size;
-
-    uint64_t current_blockchain_height = current_height;
+    uint64_t end_block = std::min<uint64_t>(blk_no + blockchain_chunk_size,
+                                            current_height);
 
-    // blockchain_chunk_gap is used so that we
-    // never read and store few top blocks
-    // the emission in the top few blocks will be calcalted
-    // later
-    end_block = end_block > current_blockchain_height
-                ? current_blockchain_height - blockchain_chunk_gap
-                : end_block;
+    vector<EmissionLedger::block_emission> blocks;
 
-    Emission emission_calculated = calculate_emission_in_blocks(blk_no, end_block);
+    if (!calculate_emission_in_blocks(blk_no, end_block, blocks))
+        return;
 
-    current_emission.coinbase += emission_calculated.coinbase;
-    current_emission.fee      += emission_calculated.fee;
-    current_emission.blk_no    = emission_calculated.blk_no;
-
-    total_emission_atomic = current_emission;
+    append_to_emission_ledger(blocks);
 }
 
-CurrentBlockchainStatus::Emission
-CurrentBlockchainStatus::calculate_emission_in_blocks(
-        uint64_t start_blk, uint64_t end_blk)
+bool
+CurrentBlockchainStatus::catch_up_emission_amount()
 {
-    Emission emission_calculated {0, 0, 0};
+    uint64_t start_block = emission_ledger.size();
 
-    while (start_blk < end_blk)
-    {
-        block blk;
+    uint64_t end_block = current_height;
+
+    uint64_t no_of_threads = catchup_threads > 0
+                             ? catchup_threads
+                             : std::max(1u, std::thread::hardware_concurrency());
 
-        mcore->get_block_by_height(start_blk, blk);
+    cout << "Catching up emission from block " << start_block
+         << " to " << end_block << " using " << no_of_threads
+         << " threads" << endl;
 
-        uint64_t coinbase_amount = get_outs_money_amount(blk.miner_tx);
+    while (start_block + blockchain_chunk_size <= end_block)
+    {
+        // each round of chunks takes only few seconds,
+        // so the thread can be stopped between them
+        boost::this_thread::interruption_point();
 
-        vector<transaction> txs;
-        vector<crypto::hash> missed_txs;
+        vector<vector<EmissionLedger::block_emission>> chunks;
+        vector<std::future<bool>> chunk_ftrs;
 
-        uint64_t tx_fee_amount = 0;
+        chunks.reserve(no_of_threads);
 
-        core_storage->get_transactions(blk.tx_hashes, txs, missed_txs);
+        uint64_t chunk_start = start_block;
 
-        for(const auto& tx: txs)
+        while (chunks.size() < no_of_threads && chunk_start < end_block)
         {
-            tx_fee_amount += get_tx_fee(tx);
+            uint64_t chunk_end = std::min(chunk_start + blockchain_chunk_size,
+                                          end_block);
+
+            chunks.emplace_back();
+
+            chunk_ftrs.push_back(std::async(std::launch::async,
+                                            calculate_emission_in_blocks,
+                                            chunk_start, chunk_end,
+                                            std::ref(chunks.back())));
+
+            chunk_start = chunk_end;
         }
 
-        (void) missed_txs;
+        // chunks are consecutive, so they are
+        // just appended to the ledger in order
+        for (size_t i = 0; i < chunk_ftrs.size(); ++i)
+        {
+            bool chunk_ok {false};
+
+            try
+            {
+                chunk_ok = chunk_ftrs[i].get();
+            }
+            catch (std::exception const& e)
+            {
+                cerr << "Calculating emission chunk failed: "
+                     << e.what() << endl;
+            }
+
+            // what we got so far is kept, and the rest is
+            // calculated again in the next try.
+            if (!chunk_ok || !append_to_emission_ledger(chunks[i]))
+                return false;
+        }
 
-        emission_calculated.coinbase += coinbase_amount - tx_fee_amount;
-        emission_calculated.fee      += tx_fee_amount;
+        start_block = chunk_start;
 
-        ++start_blk;
+        cout << "emission calculated up to block: " << start_block << endl;
     }
 
-    emission_calculated.blk_no  = start_blk;
-
-    return emission_calculated;
+    return true;
 }
 
-
 bool
-CurrentBlockchainStatus::save_current_emission_amount()
+CurrentBlockchainStatus::calculate_emission_in_blocks(
+        uint64_t start_blk, uint64_t end_blk,
+        vector<EmissionLedger::block_emission>& blocks)
 {
+    BlockchainDB& db = core_storage->get_db();
 
-    string emmision_saved_file = get_output_file_path().string();
+    blocks.reserve(blocks.size() + (end_blk - start_blk));
 
-    ofstream out(emmision_saved_file);
-
-    if( !out )
+    try
     {
-        cerr << "Couldn't open file."  << endl;
-        return false;
-    }
+        // lmdb keeps, for each block, coins generated so far,
+        // i.e., sum of coinbase outputs without fees. So fees
+        // in a block are what its miner got over newly generated
+        // coins, and only miner txs need to be read, not all txs.
+        uint64_t generated_coins = start_blk > 0
+                                   ? db.get_block_already_generated_coins(start_blk - 1)
+                                   : 0;
+
+        while (start_blk < end_blk)
+        {
+            block blk;
 
-    Emission current_emission = total_emission_atomic;
+            if (!mcore->get_block_by_height(start_blk, blk))
+                return false;
 
-    out << string(current_emission) << flush;
+            uint64_t coinbase_amount = get_outs_money_amount(blk.miner_tx);
 
-    return true;
-}
+            uint64_t block_generated_coins
+                    = db.get_block_already_generated_coins(start_blk);
 
+            uint64_t tx_fee_amount {0};
 
-bool
-CurrentBlockchainStatus::load_current_emission_amount()
-{
-    string emmision_saved_file = get_output_file_path().string();
+            if (block_generated_coins < MONEY_SUPPLY)
+            {
+                tx_fee_amount = coinbase_amount
+                                - (block_generated_coins - generated_coins);
+            }
+            else
+            {
+                // generated coins in lmdb stop at MONEY_SUPPLY, so
+                // from then on, fees are summed from the txs.
+                tx_fee_amount = get_block_tx_fees(blk);
+            }
 
-    string last_saved_emmision = xmreg::read(emmision_saved_file);
+            generated_coins = block_generated_coins;
 
-    if (last_saved_emmision.empty())
-    {
-        cerr << "Couldn't open file." << endl;
-        return false;
-    }
+            EmissionLedger::block_emission blk_emission;
 
-    last_saved_emmision.erase(last_saved_emmision.find_last_not_of(" \n\r\t")+1);
+            blk_emission.coinbase = coinbase_amount - tx_fee_amount;
+            blk_emission.fee      = tx_fee_amount;
+            blk_emission.blk_hash = db.get_block_hash_from_height(start_blk);
 
-    vector<string> strs;
-    boost::split(strs, last_saved_emmision, boost::is_any_of(","));
+            blocks.push_back(blk_emission);
 
-    if (strs.empty())
+            ++start_blk;
+        }
+    }
+    catch (std::exception const& e)
     {
-        cerr << "Problem spliting string values form  emission_amount." << endl;
+        cerr << "Cant calculate emission of block " << start_blk
+             << ": " << e.what() << endl;
         return false;
     }
 
-    Emission emission_loaded {0, 0, 0};
+    return true;
+}
 
-    uint64_t read_check_sum {0};
+uint64_t
+CurrentBlockchainStatus::get_block_tx_fees(block const& blk)
+{
+    vector<transaction> txs;
+    vector<crypto::hash> missed_txs;
 
-    try
+    uint64_t tx_fee_amount = 0;
+
+    core_storage->get_transactions(blk.tx_hashes, txs, missed_txs);
+
+    for(const auto& tx: txs)
     {
-        emission_loaded.blk_no   = boost::lexical_cast<uint64_t>(strs.at(0));
-        emission_loaded.coinbase = boost::lexical_cast<uint64_t>(strs.at(1));
-        emission_loaded.fee      = boost::lexical_cast<uint64_t>(strs.at(2));
-        read_check_sum           = boost::lexical_cast<uint64_t>(strs.at(3));
-    }
-    catch (boost::bad_lexical_cast &e)
-    {
-        cerr << "Cant parse to number date from string: " << last_saved_emmision << endl;
-        return false;
+        tx_fee_amount += get_tx_fee(tx);
     }
 
-    if (read_check_sum != emission_loaded.checksum())
+    (void) missed_txs;
+
+    return tx_fee_amount;
+}
+
+bool
+CurrentBlockchainStatus::append_to_emission_ledger(
+        vector<EmissionLedger::block_emission> const& blocks)
+{
+    bool appended = emission_ledger.append(blocks);
+
+    EmissionLedger::record ledger_tip = emission_ledger.tip();
+
+    total_emission_atomic = Emission {ledger_tip.coinbase,
+                                      ledger_tip.fee,
+                                      emission_ledger.size()};
+
+    return appended;
+}
+
+bool
+CurrentBlockchainStatus::remove_orphaned_blocks()
+{
+    BlockchainDB& db = core_storage->get_db();
+
+    uint64_t ledger_size = emission_ledger.size();
+
+    // blockchain could also get shorter
+    uint64_t new_size = std::min<uint64_t>(ledger_size, current_height);
+
+    // reorganizations are only few blocks deep, so we
+    // just go back until the block hashes match
+    while (new_size > 0)
     {
-        cerr << "read_check_sum != check_sum: "
-             << read_check_sum << " != " << emission_loaded.checksum()
-             << endl;
+        EmissionLedger::record rec;
 
-        return false;
+        if (!emission_ledger.get_record(new_size - 1, rec))
+            return false;
+
+        crypto::hash blk_hash;
+
+        try
+        {
+            blk_hash = db.get_block_hash_from_height(new_size - 1);
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant get hash of block " << (new_size - 1)
+                 << ": " << e.what() << endl;
+            return false;
+        }
+
+        if (rec.hash_prefix == EmissionLedger::hash_prefix(blk_hash))
+            break;
+
+        --new_size;
     }
 
-    total_emission_atomic = emission_loaded;
+    if (new_size == ledger_size)
+        return true;
 
-    return true;
+    cout << "Removing " << (ledger_size - new_size)
+         << " orphaned blocks from emission ledger" << endl;
+
+    bool truncated = emission_ledger.truncate(new_size);
+
+    EmissionLedger::record ledger_tip = emission_ledger.tip();
 
+    total_emission_atomic = Emission {ledger_tip.coinbase,
+                                      ledger_tip.fee,
+                                      emission_ledger.size()};
+
+    return truncated;
 }
 
 bf::path
@@ -251,44 +369,45 @@ CurrentBlockchainStatus::get_output_file_path()
 CurrentBlockchainStatus::Emission
 CurrentBlockchainStatus::get_emission()
 {
-    // get current emission
-    Emission current_emission = total_emission_atomic;
+    return total_emission_atomic;
+}
+
+bool
+CurrentBlockchainStatus::get_emission_at(uint64_t height, Emission& emission)
+{
+    EmissionLedger::record rec;
 
-    // this emission will be few blocks behind current blockchain
-    // height. By default 3 blocks. So we need to calcualate here
-    // the emission from the top missing blocks, to have complete
-    // emission data.
+    if (!emission_ledger.get_record(height, rec))
+        return false;
 
-    uint64_t current_blockchain_height = current_height;
+    emission = Emission {rec.coinbase, rec.fee, height + 1};
 
-    uint64_t start_blk = current_emission.blk_no;
+    return true;
+}
 
-    // this should be at current hight or above
-    // as we calculate missing blocks only for top blockchain
-    // height
-    uint64_t end_block = start_blk + blockchain_chunk_gap;
+bool
+CurrentBlockchainStatus::get_emission_between(uint64_t start_height,
+                                              uint64_t end_height,
+                                              Emission& emission)
+{
+    if (start_height > end_height)
+        return false;
 
-    if (end_block >= current_blockchain_height
-        && start_blk < current_blockchain_height)
-    {
-        // make sure we are not over the blockchain height
-        end_block = end_block > current_blockchain_height
-                    ? current_blockchain_height : end_block;
+    if (!get_emission_at(end_height, emission))
+        return false;
 
-        // calculated emission for missing blocks
-        Emission gap_emission_calculated
-                = calculate_emission_in_blocks(start_blk, end_block);
+    if (start_height == 0)
+        return true;
 
-        //cout << "gap_emission_calculated: " << std::string(gap_emission_calculated) << endl;
+    Emission before_start;
 
-        current_emission.coinbase += gap_emission_calculated.coinbase;
-        current_emission.fee      += gap_emission_calculated.fee;
-        current_emission.blk_no    = gap_emission_calculated.blk_no > 0
-                                     ? gap_emission_calculated.blk_no
-                                     : current_emission.blk_no;
-    }
+    if (!get_emission_at(start_height - 1, before_start))
+        return false;
 
-    return current_emission;
+    emission.coinbase -= before_start.coinbase;
+    emission.fee      -= before_start.fee;
+
+    return true;
 }
 
 bool
@@ -301,18 +420,20 @@ bf::path CurrentBlockchainStatus::blockchain_path {"/home/mwo/.bitmonero/lmdb"};
 
 cryptonote::network_type CurrentBlockchainStatus::nettype {cryptonote::network_type::MAINNET};
 
-string CurrentBlockchainStatus::output_file {"emission_amount.txt"};
+string CurrentBlockchainStatus::output_file {"emission_ledger.bin"};
 
 string CurrentBlockchainStatus::daemon_url {"http:://127.0.0.1:18081"};
 
 uint64_t  CurrentBlockchainStatus::blockchain_chunk_size {10000};
 
-uint64_t  CurrentBlockchainStatus::blockchain_chunk_gap {3};
+uint64_t  CurrentBlockchainStatus::catchup_threads {0};
 
 atomic<uint64_t> CurrentBlockchainStatus::current_height {0};
 
 atomic<CurrentBlockchainStatus::Emission> CurrentBlockchainStatus::total_emission_atomic;
 
+EmissionLedger CurrentBlockchainStatus::emission_ledger;
+
 boost::thread      CurrentBlockchainStatus::m_thread;
 
 atomic<bool>     CurrentBlockchainStatus::is_running {false};
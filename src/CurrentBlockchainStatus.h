@@ -6,11 +6,14 @@
 #define XMRBLOCKS_CURRENTBLOCKCHAINSTATUS_H
 
 #include "MicroCore.h"
+#include "ChainNotifier.h"
+#include "EmissionLedger.h"
 
 #include <boost/algorithm/string.hpp>
 
 #include <iostream>
 #include <memory>
+#include <future>
 #include <thread>
 #include <mutex>
 #include <atomic>
@@ -56,21 +59,23 @@ struct CurrentBlockchainStatus
     // how many blocks to read before thread goes to sleep
     static uint64_t blockchain_chunk_size;
 
-    // gap from what we store total_emission_atomic and
-    // current blockchain height. We dont want to store
-    // what is on, e.g., top block, as this can get messy
-    // if the block gets orphaned or blockchain reorganization
-    // occurs. So the top 3 blocks (default number) will always
-    // be calculated in flight and added to what we have so far.
-    static uint64_t blockchain_chunk_gap;
+    // number of threads used to calculate emission when
+    // we are far behind current blockchain height, e.g.,
+    // on the first start. 0 means based on the cpu.
+    static uint64_t catchup_threads;
 
     // current blockchain height and
     // hash of top block
     static atomic<uint64_t> current_height;
 
 
+    // emission up to the last block in emission_ledger
     static atomic<Emission> total_emission_atomic;
 
+    // emission of every block. Blocks orphaned by
+    // a reorganization are removed from its end.
+    static EmissionLedger emission_ledger;
+
 
     static boost::thread m_thread;
 
@@ -90,18 +95,41 @@ struct CurrentBlockchainStatus
     static void
     update_current_emission_amount();
 
-    static Emission
-    calculate_emission_in_blocks(uint64_t start_blk, uint64_t end_blk);
+    // calculates emission of remaining blocks, chunk by chunk,
+    // in parallel. Progress is saved after each round of chunks.
+    static bool
+    catch_up_emission_amount();
+
+    // emission of each block in [start_blk, end_blk)
+    static bool
+    calculate_emission_in_blocks(uint64_t start_blk, uint64_t end_blk,
+                                 vector<EmissionLedger::block_emission>& blocks);
+
+    // fees of all txs in the block, read from the txs themselves
+    static uint64_t
+    get_block_tx_fees(block const& blk);
 
     static bool
-    save_current_emission_amount();
+    append_to_emission_ledger(vector<EmissionLedger::block_emission> const& blocks);
 
+    // removes blocks from the end of the ledger which are not
+    // in the blockchain anymore, e.g., after a reorganization
     static bool
-    load_current_emission_amount();
+    remove_orphaned_blocks();
 
     static Emission
     get_emission();
 
+    // emission up to and including the block at the given height,
+    // i.e., supply at that height
+    static bool
+    get_emission_at(uint64_t height, Emission& emission);
+
+    // emission of blocks from start_height to end_height, inclusive
+    static bool
+    get_emission_between(uint64_t start_height, uint64_t end_height,
+                         Emission& emission);
+
     static bf::path
     get_output_file_path();
 
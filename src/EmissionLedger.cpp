@@ -0,0 +1,210 @@
+//
+// Created on 18/10/26.
+//
+
+#include "EmissionLedger.h"
+
+#include <cstring>
+
+namespace xmreg
+{
+
+using Guard = std::lock_guard<std::mutex>;
+
+bool
+EmissionLedger::open(bf::path const& _ledger_path)
+{
+    Guard lck (ledger_mutx);
+
+    ledger_path = _ledger_path;
+
+    boost::system::error_code ec;
+
+    if (!bf::exists(ledger_path, ec))
+    {
+        // fstream in in|out mode does not create files
+        std::ofstream new_file {ledger_path.string(), std::ios::binary};
+
+        if (!new_file)
+        {
+            cerr << "Cant create emission ledger: " << ledger_path << endl;
+            return false;
+        }
+    }
+
+    uint64_t file_size = bf::file_size(ledger_path, ec);
+
+    if (ec)
+    {
+        cerr << "Cant get size of emission ledger " << ledger_path
+             << ": " << ec.message() << endl;
+        return false;
+    }
+
+    if (file_size % sizeof(record) != 0)
+    {
+        cerr << "Removing partial record from the end of emission ledger "
+             << ledger_path << endl;
+
+        file_size -= file_size % sizeof(record);
+
+        bf::resize_file(ledger_path, file_size, ec);
+
+        if (ec)
+        {
+            cerr << "Cant resize emission ledger: " << ec.message() << endl;
+            return false;
+        }
+    }
+
+    ledger_file.open(ledger_path.string(),
+                     std::ios::in | std::ios::out | std::ios::binary);
+
+    if (!ledger_file)
+    {
+        cerr << "Cant open emission ledger: " << ledger_path << endl;
+        return false;
+    }
+
+    no_of_records = file_size / sizeof(record);
+
+    last_record = record {};
+
+    if (no_of_records > 0)
+    {
+        ledger_file.seekg((no_of_records - 1) * sizeof(record));
+        ledger_file.read(reinterpret_cast<char*>(&last_record), sizeof(record));
+
+        if (!ledger_file)
+        {
+            cerr << "Cant read last record of emission ledger" << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint64_t
+EmissionLedger::size() const
+{
+    Guard lck (ledger_mutx);
+    return no_of_records;
+}
+
+EmissionLedger::record
+EmissionLedger::tip() const
+{
+    Guard lck (ledger_mutx);
+    return last_record;
+}
+
+bool
+EmissionLedger::append(vector<block_emission> const& blocks)
+{
+    if (blocks.empty())
+        return true;
+
+    vector<record> new_records;
+    new_records.reserve(blocks.size());
+
+    Guard lck (ledger_mutx);
+
+    record rec = last_record;
+
+    for (block_emission const& blk: blocks)
+    {
+        rec.coinbase   += blk.coinbase;
+        rec.fee        += blk.fee;
+        rec.hash_prefix = hash_prefix(blk.blk_hash);
+
+        new_records.push_back(rec);
+    }
+
+    ledger_file.seekp(no_of_records * sizeof(record));
+    ledger_file.write(reinterpret_cast<char const*>(new_records.data()),
+                      new_records.size() * sizeof(record));
+    ledger_file.flush();
+
+    if (!ledger_file)
+    {
+        cerr << "Cant append to emission ledger " << ledger_path << endl;
+
+        // partially written records are removed when
+        // the ledger is opened next time
+        ledger_file.clear();
+        return false;
+    }
+
+    no_of_records += new_records.size();
+    last_record    = new_records.back();
+
+    return true;
+}
+
+bool
+EmissionLedger::get_record(uint64_t height, record& rec) const
+{
+    Guard lck (ledger_mutx);
+
+    if (height >= no_of_records)
+        return false;
+
+    ledger_file.seekg(height * sizeof(record));
+    ledger_file.read(reinterpret_cast<char*>(&rec), sizeof(record));
+
+    if (!ledger_file)
+    {
+        ledger_file.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool
+EmissionLedger::truncate(uint64_t new_size)
+{
+    Guard lck (ledger_mutx);
+
+    if (new_size >= no_of_records)
+        return true;
+
+    ledger_file.close();
+
+    boost::system::error_code ec;
+
+    bf::resize_file(ledger_path, new_size * sizeof(record), ec);
+
+    ledger_file.open(ledger_path.string(),
+                     std::ios::in | std::ios::out | std::ios::binary);
+
+    if (ec || !ledger_file)
+    {
+        cerr << "Cant truncate emission ledger " << ledger_path
+             << ": " << ec.message() << endl;
+        return false;
+    }
+
+    no_of_records = new_size;
+
+    last_record = record {};
+
+    if (no_of_records > 0)
+    {
+        ledger_file.seekg((no_of_records - 1) * sizeof(record));
+        ledger_file.read(reinterpret_cast<char*>(&last_record), sizeof(record));
+    }
+
+    return static_cast<bool>(ledger_file);
+}
+
+uint64_t
+EmissionLedger::hash_prefix(crypto::hash const& blk_hash)
+{
+    uint64_t prefix;
+    memcpy(&prefix, blk_hash.data, sizeof(prefix));
+    return prefix;
+}
+
+}
@@ -0,0 +1,107 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_EMISSIONLEDGER_H
+#define XMRBLOCKS_EMISSIONLEDGER_H
+
+#include "monero_headers.h"
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+namespace bf = boost::filesystem;
+
+/**
+ * Append-only binary file with emission of every block.
+ *
+ * The file is just an array of fixed size records, one for each
+ * block, so a record of a block at height h starts at
+ * h * sizeof(record). Each record has cumulative coinbase and fees
+ * up to and including the block, so supply at a given height,
+ * emission of a single block or emission between two heights
+ * are one or two record reads.
+ *
+ * Records also keep first 8 bytes of their block hashes, so that
+ * blocks orphaned by a reorganization can be found and cut off
+ * from the end of the ledger.
+ *
+ * Values are stored in the byte order of the host.
+ */
+class EmissionLedger
+{
+public:
+
+    struct record
+    {
+        uint64_t coinbase {0};      // cumulative, without fees
+        uint64_t fee {0};           // cumulative
+        uint64_t hash_prefix {0};   // of the block hash
+    };
+
+    static_assert(sizeof(record) == 24, "record must be 24 bytes");
+
+    // emission of a single block, as calculated from the blockchain
+    struct block_emission
+    {
+        uint64_t coinbase {0};
+        uint64_t fee {0};
+        crypto::hash blk_hash {crypto::null_hash};
+    };
+
+    /**
+     * Opens existing ledger or creates new one. Partial record at
+     * the end, e.g., due to crash while appending, is removed.
+     */
+    bool
+    open(bf::path const& _ledger_path);
+
+    // no of blocks in the ledger, i.e.,
+    // height of the next block to be appended
+    uint64_t
+    size() const;
+
+    // record of the last block in the ledger,
+    // or empty record if the ledger is empty
+    record
+    tip() const;
+
+    bool
+    append(vector<block_emission> const& blocks);
+
+    bool
+    get_record(uint64_t height, record& rec) const;
+
+    // removes blocks at height new_size and above
+    bool
+    truncate(uint64_t new_size);
+
+    static uint64_t
+    hash_prefix(crypto::hash const& blk_hash);
+
+private:
+
+    bf::path ledger_path;
+
+    mutable std::mutex ledger_mutx;
+
+    mutable std::fstream ledger_file;
+
+    uint64_t no_of_records {0};
+
+    record last_record;
+};
+
+}
+
+#endif //XMRBLOCKS_EMISSIONLEDGER_H
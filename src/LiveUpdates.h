@@ -0,0 +1,317 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_LIVEUPDATES_H
+#define XMRBLOCKS_LIVEUPDATES_H
+
+#include "MicroCore.h"
+#include "MempoolStatus.h"
+#include "ChainNotifier.h"
+#include "tools.h"
+
+#include "../ext/crow_all.h"
+#include "../ext/json.hpp"
+
+#include <boost/thread.hpp>
+
+#include <iostream>
+#include <mutex>
+#include <unordered_set>
+
+namespace xmreg
+{
+
+using namespace std;
+
+using json = nlohmann::json;
+
+/**
+ * Pushes new blocks and mempool changes to viewers of autorefresh
+ * pages over websocket, so that their pages are patched by a small
+ * script, instead of being reloaded and rendered in full every
+ * 10 seconds.
+ *
+ * A single thread waits for changes detected by ChainNotifier
+ * (or checks every poll_interval if it is not running) and
+ * sends the same few hundred bytes to all viewers:
+ *
+ *  {"type": "block", "height": ..., "hash": ..., "timestamp": ...,
+ *   "size": ..., "no_txs": ...}
+ *
+ *  {"type": "mempool", "no_txs": ..., "size": ...,
+ *   "added": [{"hash": ..., "fee": ..., "payed_for_kB": ...,
+ *              "no_inputs": ..., "no_outputs": ..., "txsize": ...}],
+ *   "removed": [hash, ...], "truncated": false}
+ *
+ * Confirmations of txs are worked out from block heights by
+ * the script. Fees and sizes are formatted as on the pages.
+ */
+class LiveUpdates
+{
+public:
+
+    // newest txs of a mempool change which are sent in full
+    static constexpr size_t max_added_txs {25};
+
+    // more removed txs than that, e.g., when a big block
+    // is mined, make viewers reload the page instead
+    static constexpr size_t max_removed_txs {200};
+
+    // blocks older than that are not sent after
+    // a long sync or a reorganization
+    static constexpr uint64_t max_new_blocks {10};
+
+    LiveUpdates() = default;
+
+    LiveUpdates(LiveUpdates const&) = delete;
+    LiveUpdates& operator=(LiveUpdates const&) = delete;
+
+    ~LiveUpdates()
+    {
+        stop();
+    }
+
+    void
+    start(Blockchain* _core_storage,
+          size_t _max_viewers,
+          uint64_t _poll_interval)
+    {
+        core_storage  = _core_storage;
+        max_viewers   = _max_viewers;
+        poll_interval = _poll_interval;
+
+        m_thread = boost::thread {[this]() { run(); }};
+    }
+
+    void
+    stop()
+    {
+        if (!m_thread.joinable())
+            return;
+
+        m_thread.interrupt();
+        m_thread.join();
+    }
+
+    // false if there are already max_viewers
+    bool
+    add_viewer(crow::websocket::connection* conn)
+    {
+        std::lock_guard<std::mutex> lck (viewers_mutx);
+
+        if (max_viewers > 0 && viewers.size() >= max_viewers)
+            return false;
+
+        viewers.insert(conn);
+
+        return true;
+    }
+
+    void
+    remove_viewer(crow::websocket::connection* conn)
+    {
+        std::lock_guard<std::mutex> lck (viewers_mutx);
+        viewers.erase(conn);
+    }
+
+    bool
+    can_accept()
+    {
+        std::lock_guard<std::mutex> lck (viewers_mutx);
+        return max_viewers == 0 || viewers.size() < max_viewers;
+    }
+
+    size_t
+    no_of_viewers()
+    {
+        std::lock_guard<std::mutex> lck (viewers_mutx);
+        return viewers.size();
+    }
+
+private:
+
+    void
+    run()
+    {
+        uint64_t chain_version {ChainNotifier::chain_version};
+
+        last_height   = core_storage->get_current_blockchain_height();
+        last_top_hash = core_storage->get_db().top_block_hash();
+
+        last_snapshot = MempoolStatus::get_mempool_snapshot();
+
+        // proxies close websockets which are idle for too long
+        auto last_ping = std::chrono::steady_clock::now();
+
+        while (true)
+        {
+            try
+            {
+                // wakes up at once for a new block. mempool snapshot
+                // changes after MempoolStatus thread refreshes it,
+                // so it is checked at least every poll_interval
+                ChainNotifier::wait_for_chain_change(
+                        chain_version,
+                        boost::chrono::milliseconds {poll_interval});
+
+                check_new_blocks();
+                check_mempool();
+
+                if (std::chrono::steady_clock::now() - last_ping
+                        > std::chrono::seconds {30})
+                {
+                    broadcast(json {{"type", "ping"}}.dump());
+                    last_ping = std::chrono::steady_clock::now();
+                }
+            }
+            catch (boost::thread_interrupted const&)
+            {
+                cout << "Live updates thread interrupted." << endl;
+                return;
+            }
+            catch (std::exception const& e)
+            {
+                cerr << "Live updates: " << e.what() << endl;
+            }
+        }
+    }
+
+    void
+    check_new_blocks()
+    {
+        uint64_t height = core_storage->get_current_blockchain_height();
+
+        if (height == 0)
+            return;
+
+        crypto::hash top_hash = core_storage->get_db().top_block_hash();
+
+        if (height == last_height && top_hash == last_top_hash)
+            return;
+
+        // after reorganization, the top block
+        // is sent again, even if at the same height
+        uint64_t start_height = std::min(last_height, height - 1);
+
+        start_height = std::max(start_height, height - std::min(height, max_new_blocks));
+
+        for (uint64_t blk_height = start_height; blk_height < height; ++blk_height)
+        {
+            BlockchainDB& db = core_storage->get_db();
+
+            block blk = db.get_block_from_height(blk_height);
+
+            double blk_size = static_cast<double>(
+                    db.get_block_weight(blk_height))/1024.0;
+
+            broadcast(json {
+                    {"type"     , "block"},
+                    {"height"   , blk_height},
+                    {"hash"     , pod_to_hex(db.get_block_hash_from_height(blk_height))},
+                    {"timestamp", blk.timestamp},
+                    {"size"     , fmt::format("{:0.2f}", blk_size)},
+                    {"no_txs"   , blk.tx_hashes.size()}}.dump());
+        }
+
+        last_height   = height;
+        last_top_hash = top_hash;
+    }
+
+    void
+    check_mempool()
+    {
+        MempoolStatus::mempool_snapshot_ptr snapshot
+                = MempoolStatus::get_mempool_snapshot();
+
+        if (snapshot->version == last_snapshot->version)
+            return;
+
+        json j_added   = json::array();
+        json j_removed = json::array();
+
+        bool truncated {false};
+
+        // rows are from the newest tx
+        for (size_t row = 0; row < snapshot->size(); ++row)
+        {
+            if (last_snapshot->rows_by_hash.count(snapshot->tx_hashes[row]))
+                continue;
+
+            if (j_added.size() == max_added_txs)
+                break;
+
+            double tx_size = static_cast<double>(snapshot->blob_sizes[row])/1024.0;
+
+            double payed_for_kB = XMR_AMOUNT(snapshot->fees[row]) / tx_size;
+
+            j_added.push_back(json {
+                    {"hash"        , pod_to_hex(snapshot->tx_hashes[row])},
+                    {"fee"         , xmreg::xmr_amount_to_str(snapshot->fees[row]*1.0e6, "{:04.0f}", false)},
+                    {"payed_for_kB", fmt::format("{:04.0f}", payed_for_kB*1e6)},
+                    {"no_inputs"   , snapshot->no_inputs[row]},
+                    {"no_outputs"  , snapshot->no_outputs[row]},
+                    {"txsize"      , fmt::format("{:0.2f}", tx_size)}});
+        }
+
+        for (crypto::hash const& tx_hash: last_snapshot->tx_hashes)
+        {
+            if (snapshot->rows_by_hash.count(tx_hash))
+                continue;
+
+            if (j_removed.size() == max_removed_txs)
+            {
+                truncated = true;
+                break;
+            }
+
+            j_removed.push_back(pod_to_hex(tx_hash));
+        }
+
+        uint64_t mempool_size_bytes = snapshot->size_bytes;
+
+        broadcast(json {
+                {"type"     , "mempool"},
+                {"no_txs"   , snapshot->size()},
+                {"size"     , fmt::format("{:0.2f}",
+                                          static_cast<double>(mempool_size_bytes)/1024.0)},
+                {"added"    , j_added},
+                {"removed"  , j_removed},
+                {"truncated", truncated}}.dump());
+
+        last_snapshot = std::move(snapshot);
+    }
+
+    // send_text only queues the message on the
+    // connection's thread, so this does not block
+    void
+    broadcast(string const& msg)
+    {
+        std::lock_guard<std::mutex> lck (viewers_mutx);
+
+        for (crow::websocket::connection* conn: viewers)
+            conn->send_text(msg);
+    }
+
+    Blockchain* core_storage {nullptr};
+
+    // 0 means no limit
+    size_t max_viewers {0};
+
+    uint64_t poll_interval {1000};
+
+    std::mutex viewers_mutx;
+
+    unordered_set<crow::websocket::connection*> viewers;
+
+    // used only by the thread
+    uint64_t last_height {0};
+    crypto::hash last_top_hash {crypto::null_hash};
+    MempoolStatus::mempool_snapshot_ptr last_snapshot;
+
+    boost::thread m_thread;
+};
+
+}
+
+#endif //XMRBLOCKS_LIVEUPDATES_H
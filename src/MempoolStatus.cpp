@@ -3,6 +3,7 @@
 //
 
 #include "MempoolStatus.h"
+#include "Metrics.h"
 
 
 namespace xmreg
@@ -39,17 +40,18 @@ MempoolStatus::start_mempool_status_thread()
         {
          try
          {
-             uint64_t loop_index {0};
+            uint64_t mempool_version {ChainNotifier::mempool_version};
 
             // so that network status is checked every minute
-            uint64_t loop_index_divider = std::max<uint64_t>(1, 60 / mempool_refresh_time);
+            auto network_info_read_time = boost::chrono::steady_clock::time_point {};
 
             while (true)
             {
 
              // we just query network status every minute. No sense
              // to do it as frequently as getting mempool data.
-             if (loop_index % loop_index_divider == 0)
+             if (boost::chrono::steady_clock::now() - network_info_read_time
+                     >= boost::chrono::seconds(60))
              {
                  if (!MempoolStatus::read_network_info())
                  {
@@ -64,26 +66,30 @@ MempoolStatus::start_mempool_status_thread()
                  else
                  {
                      cout << "Current network info read, ";
-                     loop_index = 0;
                  }
+
+                 network_info_read_time = boost::chrono::steady_clock::now();
              }
 
+             auto read_start = Metrics::clock::now();
+
              if (MempoolStatus::read_mempool())
              {
-                 auto current_mempool_txs = get_mempool_txs();
+                 Metrics::mempool_refresh_duration.get()
+                         .observe(Metrics::elapsed_us(read_start));
 
                  cout << "mempool status txs: "
-                      << (current_mempool_txs ? current_mempool_txs->size() : 0)
+                      << get_mempool_snapshot()->size()
                       << endl;
              }
 
-             // when we reach top of the blockchain, update
-             // the emission amount every minute.
-             boost::this_thread::sleep_for(
+             // wait till ChainNotifier detects a change in the mempool,
+             // but no longer than mempool_refresh_time. If ChainNotifier
+             // is not running, this just sleeps mempool_refresh_time.
+             ChainNotifier::wait_for_mempool_change(
+                     mempool_version,
                      boost::chrono::seconds(mempool_refresh_time));
 
-             ++loop_index;
-
              } // while (true)
          }
          catch (boost::thread_interrupted&)
@@ -107,123 +113,317 @@ MempoolStatus::read_mempool()
     // Removed unused rpccalls instance to prevent memory leak from
     // creating ~360 HTTP client instances per hour
 
-    // we populate this variable instead of global mempool_txs
-    // mempool_txs will be changed only when this function completes.
+    // we populate new snapshot instead of global current_snapshot
+    // current_snapshot will be changed only when this function completes.
     // this ensures that we don't sent out partial mempool txs to
     // other places.
-    vector<mempool_tx> local_copy_of_mempool_txs;
+    //
+    // txs parsed in the previous refresh are taken from
+    // the previous snapshot. Its rows whose txs are not in the txpool
+    // anymore have left the mempool, and are just not taken
+    // to the new snapshot.
+    mempool_snapshot_ptr previous_snapshot = get_mempool_snapshot();
+
+    size_t const previous_size = previous_snapshot->size();
+
+    // rows of the previous snapshot whose txs are still in the txpool
+    vector<uint8_t> is_staying(previous_size, 0);
+
+    // hashes and metadata of txs which arrived since the previous
+    // refresh. Only their blobs are read and parsed.
+    vector<pair<crypto::hash, txpool_tx_meta_t>> new_txs_meta;
+
+    static Metrics::counter& txpool_reads
+            = Metrics::lmdb_reads.get("for_all_txpool_txes");
 
-    // get txs in the mempool
-    std::vector<tx_info> mempool_tx_info;
+    static Metrics::counter& blob_reads
+            = Metrics::lmdb_reads.get("get_txpool_tx_blob");
 
-    //std::vector<tx_info> pool_tx_info;
-    std::vector<spent_key_image_info> pool_key_image_info;
+    txpool_reads.inc();
 
-    // get txpool from lmdb database instead of rpc call
-    if (!mcore->get_mempool().get_transactions_and_spent_keys_info(
-                mempool_tx_info,
-                pool_key_image_info,
-                true))
+    try
     {
-        cerr << "Getting mempool failed " << endl;
+        core_storage->get_db().for_all_txpool_txes(
+            [&](crypto::hash const& txid,
+                txpool_tx_meta_t const& meta,
+                cryptonote::blobdata_ref const*)
+            {
+                auto it = previous_snapshot->rows_by_hash.find(txid);
+
+                if (it != previous_snapshot->rows_by_hash.end())
+                    is_staying[it->second] = 1;
+                else
+                    new_txs_meta.emplace_back(txid, meta);
+
+                return true;
+            }, false, relay_category::all);
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Getting mempool failed: " << e.what() << endl;
         return false;
     }
 
-    (void) pool_key_image_info;
+    vector<mempool_tx> new_txs;
 
-    // sort txpool txs
+    new_txs.reserve(new_txs_meta.size());
 
-    // mempool txs are not sorted base on their arival time,
-    // so we sort it here.
+    for (auto const& tx_meta: new_txs_meta)
+    {
+        crypto::hash const& tx_hash = tx_meta.first;
+
+        cryptonote::blobdata tx_blob;
+
+        blob_reads.inc();
+
+        try
+        {
+            if (!core_storage->get_db().get_txpool_tx_blob(
+                    tx_hash, tx_blob, relay_category::all))
+            {
+                // tx left the mempool in the meantime
+                continue;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "Cant get blob of mempool tx "
+                 << pod_to_hex(tx_hash) << ": " << e.what() << endl;
+            continue;
+        }
+
+        mempool_tx parsed_tx;
+
+        if (!parse_mempool_tx(tx_hash, tx_meta.second, tx_blob, parsed_tx))
+            continue;
+
+        new_txs.push_back(std::move(parsed_tx));
+    }
 
-    std::sort(mempool_tx_info.begin(), mempool_tx_info.end(),
-    [](tx_info& t1, tx_info& t2)
+    uint64_t no_of_removed_txs = previous_size
+            - std::count(is_staying.begin(), is_staying.end(), 1);
+
+    if (new_txs.empty() && no_of_removed_txs == 0)
+    {
+        // nothing arrived or left, so the previous snapshot,
+        // with its renders, stays the current one.
+        return true;
+    }
+
+    // mempool txs are not sorted base on their arival time,
+    // so we sort the new ones here, and merge them into the
+    // previous snapshot's rows, which are sorted already.
+    std::sort(new_txs.begin(), new_txs.end(),
+    [](mempool_tx const& t1, mempool_tx const& t2)
     {
         return t1.receive_time > t2.receive_time;
     });
 
+    auto new_snapshot = std::make_shared<mempool_snapshot>();
 
-    // if dont have tx_blob member, construct tx
-    // from json obtained from the rpc call
+    new_snapshot->stats = previous_snapshot->stats;
 
-    uint64_t mempool_size_kB {0};
+    new_snapshot->reserve(previous_size - no_of_removed_txs + new_txs.size());
 
-    for (size_t i = 0; i < mempool_tx_info.size(); ++i)
-    {
-        // get transaction info of the tx in the mempool
-        const tx_info& _tx_info = mempool_tx_info.at(i);
+    constexpr size_t no_row = std::numeric_limits<size_t>::max();
 
-        transaction tx;
-        crypto::hash tx_hash;
-        crypto::hash tx_prefix_hash;
+    // new rows of txs from the previous snapshot,
+    // no_row if they left the mempool
+    vector<size_t> rows_from_previous(previous_size, no_row);
 
-        if (!parse_and_validate_tx_from_blob(
-                _tx_info.tx_blob, tx, tx_hash, tx_prefix_hash))
-        {
-            cerr << "Cant make tx from _tx_info.tx_blob" << endl;
-            return false;
-        }
+    // new rows of new_txs
+    vector<size_t> rows_of_new_txs(new_txs.size());
 
-        mempool_size_kB += _tx_info.blob_size;
+    size_t previous_row {0};
+    size_t new_tx_idx {0};
 
-        local_copy_of_mempool_txs.push_back(mempool_tx{});
+    while (previous_row < previous_size || new_tx_idx < new_txs.size())
+    {
+        if (previous_row < previous_size && !is_staying[previous_row])
+        {
+            new_snapshot->stats.remove(previous_snapshot->tx(previous_row));
+            ++previous_row;
+            continue;
+        }
 
-        mempool_tx& last_tx = local_copy_of_mempool_txs.back();
+        if (new_tx_idx < new_txs.size()
+                && (previous_row == previous_size
+                    || new_txs[new_tx_idx].receive_time
+                       > previous_snapshot->receive_times[previous_row]))
+        {
+            rows_of_new_txs[new_tx_idx] = new_snapshot->size();
+            new_snapshot->stats.add(new_txs[new_tx_idx]);
+            new_snapshot->push_back(new_txs[new_tx_idx]);
+            ++new_tx_idx;
+            continue;
+        }
 
-        last_tx.tx_hash = tx_hash;
-        last_tx.tx = tx;
+        rows_from_previous[previous_row] = new_snapshot->size();
+        new_snapshot->push_back_row(*previous_snapshot, previous_row);
+        ++previous_row;
+    }
 
-        // key images of inputs
-        vector<txin_to_key> input_key_imgs;
+    // indices of the previous snapshot are carried forward. Txs which
+    // left are erased and rows of the ones which stayed are
+    // moved to their new rows. Key images of the txs which stayed are
+    // taken from here, as their full txs could have been dropped already.
+    new_snapshot->rows_by_hash      = previous_snapshot->rows_by_hash;
+    new_snapshot->rows_by_key_image = previous_snapshot->rows_by_key_image;
 
-        // public keys and xmr amount of outputs
-        vector<output_tuple_with_tag> output_pub_keys;
+    auto move_rows = [&rows_from_previous](auto& rows_by_key)
+    {
+        for (auto it = rows_by_key.begin(); it != rows_by_key.end();)
+        {
+            size_t new_row = rows_from_previous[it->second];
 
-        // sum xmr in inputs and ouputs in the given tx
-        const array<uint64_t, 4>& sum_data = summary_of_in_out_rct(
-               tx, output_pub_keys, input_key_imgs);
+            if (new_row == no_row)
+            {
+                it = rows_by_key.erase(it);
+                continue;
+            }
 
+            it->second = new_row;
+            ++it;
+        }
+    };
 
-        double tx_size =  static_cast<double>(_tx_info.blob_size)/1024.0;
+    move_rows(new_snapshot->rows_by_hash);
+    move_rows(new_snapshot->rows_by_key_image);
 
-        double payed_for_kB = XMR_AMOUNT(_tx_info.fee) / tx_size;
+    for (size_t i = 0; i < new_txs.size(); ++i)
+    {
+        size_t row = rows_of_new_txs[i];
 
-        last_tx.receive_time = _tx_info.receive_time;
+        new_snapshot->rows_by_hash.emplace(new_txs[i].tx_hash, row);
 
-        last_tx.sum_outputs       = sum_data[0];
-        last_tx.sum_inputs        = sum_data[1];
-        last_tx.no_outputs        = output_pub_keys.size();
-        last_tx.no_inputs         = input_key_imgs.size();
-        last_tx.mixin_no          = sum_data[2];
-        last_tx.num_nonrct_inputs = sum_data[3];
+        for (txin_v const& in: new_txs[i].get_tx()->vin)
+        {
+            if (in.type() == typeid(txin_to_key))
+            {
+                new_snapshot->rows_by_key_image.emplace(
+                        boost::get<txin_to_key>(in).k_image, row);
+            }
+        }
+    }
 
-        last_tx.fee_str          = xmreg::xmr_amount_to_str(_tx_info.fee, "{:0.4f}", false);
-        last_tx.fee_micro_str    = xmreg::xmr_amount_to_str(_tx_info.fee*1.0e6, "{:04.0f}", false);
-        last_tx.payed_for_kB_str = fmt::format("{:0.4f}", payed_for_kB);
-        last_tx.payed_for_kB_micro_str = fmt::format("{:04.0f}", payed_for_kB*1e6);
-        last_tx.xmr_inputs_str   = xmreg::xmr_amount_to_str(last_tx.sum_inputs , "{:0.3f}");
-        last_tx.xmr_outputs_str  = xmreg::xmr_amount_to_str(last_tx.sum_outputs, "{:0.3f}");
-        last_tx.timestamp_str    = xmreg::timestamp_to_str_gm(_tx_info.receive_time);
+    // full txs are kept only for the newest txs, as long as their
+    // blobs fit in max_full_txs_size. Txs which were dropped
+    // before, stay dropped.
+    uint64_t full_txs_size {0};
 
-        last_tx.txsize           = fmt::format("{:0.2f}", tx_size);
+    for (size_t row = 0; row < new_snapshot->size(); ++row)
+    {
+        full_txs_size += new_snapshot->blob_sizes[row];
 
-    } // for (size_t i = 0; i < mempool_tx_info.size(); ++i)
+        if (full_txs_size > max_full_txs_size)
+            new_snapshot->full_txs[row]->drop();
+    }
 
+    cout << "mempool txs added: " << new_txs.size()
+         << ", removed: " << no_of_removed_txs << ", ";
 
+    new_snapshot->timestamp  = static_cast<uint64_t>(std::time(nullptr));
+    new_snapshot->size_bytes = new_snapshot->stats.total_size;
 
     Guard lck (mempool_mutx);
 
     // Copy-on-write pattern: create new shared_ptr and swap atomically
     // This avoids expensive deep copies when multiple request handlers
     // read the mempool simultaneously
-    mempool_no   = local_copy_of_mempool_txs.size();
-    mempool_size = mempool_size_kB;
+    mempool_no   = new_snapshot->size();
+    mempool_size = new_snapshot->size_bytes;
+
+    new_snapshot->version = current_snapshot->version + 1;
 
-    mempool_txs = std::make_shared<vector<mempool_tx>>(std::move(local_copy_of_mempool_txs));
+    current_snapshot = std::move(new_snapshot);
 
     return true;
 }
 
+bool
+MempoolStatus::parse_mempool_tx(crypto::hash const& tx_hash,
+                                txpool_tx_meta_t const& meta,
+                                cryptonote::blobdata const& tx_blob,
+                                mempool_tx& parsed_tx)
+{
+    auto tx = std::make_shared<transaction>();
+
+    crypto::hash tx_hash_from_blob;
+    crypto::hash tx_prefix_hash;
+
+    if (!parse_and_validate_tx_from_blob(
+            tx_blob, *tx, tx_hash_from_blob, tx_prefix_hash))
+    {
+        cerr << "Cant make tx from tx_blob of " << pod_to_hex(tx_hash) << endl;
+        return false;
+    }
+
+    parsed_tx.tx_hash      = tx_hash;
+    parsed_tx.receive_time = meta.receive_time;
+    parsed_tx.fee          = meta.fee;
+    parsed_tx.weight       = meta.weight;
+    parsed_tx.blob_size    = tx_blob.size();
+
+    // key images of inputs
+    vector<txin_to_key> input_key_imgs;
+
+    // public keys and xmr amount of outputs
+    vector<output_tuple_with_tag> output_pub_keys;
+
+    // sum xmr in inputs and ouputs in the given tx
+    const array<uint64_t, 4>& sum_data = summary_of_in_out_rct(
+           *tx, output_pub_keys, input_key_imgs);
+
+    parsed_tx.sum_outputs       = sum_data[0];
+    parsed_tx.sum_inputs        = sum_data[1];
+    parsed_tx.no_outputs        = output_pub_keys.size();
+    parsed_tx.no_inputs         = input_key_imgs.size();
+    parsed_tx.mixin_no          = sum_data[2];
+    parsed_tx.num_nonrct_inputs = sum_data[3];
+    parsed_tx.version           = static_cast<uint8_t>(tx->version);
+    parsed_tx.rct_type          = tx->rct_signatures.type;
+
+    parsed_tx.full_tx = std::make_shared<mempool_full_tx>(tx_hash, std::move(tx));
+
+    return true;
+}
+
+std::shared_ptr<const transaction>
+MempoolStatus::load_mempool_tx(crypto::hash const& tx_hash)
+{
+    static Metrics::counter& reads
+            = Metrics::lmdb_reads.get("get_txpool_tx_blob");
+
+    reads.inc();
+
+    cryptonote::blobdata tx_blob;
+
+    try
+    {
+        if (!core_storage->get_db().get_txpool_tx_blob(
+                tx_hash, tx_blob, relay_category::all))
+        {
+            return nullptr;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant get blob of mempool tx "
+             << pod_to_hex(tx_hash) << ": " << e.what() << endl;
+        return nullptr;
+    }
+
+    auto tx = std::make_shared<transaction>();
+
+    if (!parse_and_validate_tx_from_blob(tx_blob, *tx))
+    {
+        cerr << "Cant make tx from tx_blob of " << pod_to_hex(tx_hash) << endl;
+        return nullptr;
+    }
+
+    return tx;
+}
+
 
 bool
 MempoolStatus::read_network_info()
@@ -317,28 +517,325 @@ MempoolStatus::read_network_info()
     return true;
 }
 
-MempoolStatus::mempool_txs_ptr
-MempoolStatus::get_mempool_txs()
+MempoolStatus::mempool_snapshot_ptr
+MempoolStatus::get_mempool_snapshot()
 {
     Guard lck (mempool_mutx);
-    // Return shared_ptr - just increments reference count, no deep copy
-    return mempool_txs;
+    return current_snapshot;
 }
 
-MempoolStatus::mempool_txs_ptr
-MempoolStatus::get_mempool_txs(uint64_t no_of_tx)
+size_t
+MempoolStatus::mempool_snapshot::size() const
 {
-    Guard lck (mempool_mutx);
+    return tx_hashes.size();
+}
+
+bool
+MempoolStatus::mempool_snapshot::empty() const
+{
+    return tx_hashes.empty();
+}
+
+MempoolStatus::mempool_tx
+MempoolStatus::mempool_snapshot::tx(size_t row) const
+{
+    mempool_tx row_tx;
+
+    row_tx.tx_hash           = tx_hashes[row];
+    row_tx.receive_time      = receive_times[row];
+    row_tx.fee               = fees[row];
+    row_tx.blob_size         = blob_sizes[row];
+    row_tx.weight            = weights[row];
+    row_tx.sum_inputs        = sum_inputs[row];
+    row_tx.sum_outputs       = sum_outputs[row];
+    row_tx.no_inputs         = no_inputs[row];
+    row_tx.no_outputs        = no_outputs[row];
+    row_tx.num_nonrct_inputs = num_nonrct_inputs[row];
+    row_tx.mixin_no          = mixin_nos[row];
+    row_tx.version           = versions[row];
+    row_tx.rct_type          = rct_types[row];
+    row_tx.full_tx           = full_txs[row];
+
+    return row_tx;
+}
+
+void
+MempoolStatus::mempool_snapshot::push_back(mempool_tx const& row_tx)
+{
+    tx_hashes.push_back(row_tx.tx_hash);
+    receive_times.push_back(row_tx.receive_time);
+    fees.push_back(row_tx.fee);
+    blob_sizes.push_back(row_tx.blob_size);
+    weights.push_back(row_tx.weight);
+    sum_inputs.push_back(row_tx.sum_inputs);
+    sum_outputs.push_back(row_tx.sum_outputs);
+    no_inputs.push_back(row_tx.no_inputs);
+    no_outputs.push_back(row_tx.no_outputs);
+    num_nonrct_inputs.push_back(row_tx.num_nonrct_inputs);
+    mixin_nos.push_back(row_tx.mixin_no);
+    versions.push_back(row_tx.version);
+    rct_types.push_back(row_tx.rct_type);
+    full_txs.push_back(row_tx.full_tx);
+}
+
+void
+MempoolStatus::mempool_snapshot::push_back_row(
+        mempool_snapshot const& other, size_t row)
+{
+    tx_hashes.push_back(other.tx_hashes[row]);
+    receive_times.push_back(other.receive_times[row]);
+    fees.push_back(other.fees[row]);
+    blob_sizes.push_back(other.blob_sizes[row]);
+    weights.push_back(other.weights[row]);
+    sum_inputs.push_back(other.sum_inputs[row]);
+    sum_outputs.push_back(other.sum_outputs[row]);
+    no_inputs.push_back(other.no_inputs[row]);
+    no_outputs.push_back(other.no_outputs[row]);
+    num_nonrct_inputs.push_back(other.num_nonrct_inputs[row]);
+    mixin_nos.push_back(other.mixin_nos[row]);
+    versions.push_back(other.versions[row]);
+    rct_types.push_back(other.rct_types[row]);
+    full_txs.push_back(other.full_txs[row]);
+}
 
-    if (!mempool_txs)
-        return std::make_shared<vector<mempool_tx>>();
+void
+MempoolStatus::mempool_snapshot::reserve(size_t no_of_txs)
+{
+    tx_hashes.reserve(no_of_txs);
+    receive_times.reserve(no_of_txs);
+    fees.reserve(no_of_txs);
+    blob_sizes.reserve(no_of_txs);
+    weights.reserve(no_of_txs);
+    sum_inputs.reserve(no_of_txs);
+    sum_outputs.reserve(no_of_txs);
+    no_inputs.reserve(no_of_txs);
+    no_outputs.reserve(no_of_txs);
+    num_nonrct_inputs.reserve(no_of_txs);
+    mixin_nos.reserve(no_of_txs);
+    versions.reserve(no_of_txs);
+    rct_types.reserve(no_of_txs);
+    full_txs.reserve(no_of_txs);
+}
+
+uint64_t
+MempoolStatus::mempool_snapshot::receive_time_percentile(double percentile) const
+{
+    if (empty())
+        return 0;
+
+    percentile = std::min(std::max(percentile, 0.0), 1.0);
+
+    // txs are sorted from the newest to the oldest,
+    // i.e., by their age in ascending order.
+    size_t row = static_cast<size_t>(percentile * (size() - 1) + 0.5);
+
+    return receive_times[row];
+}
+
+void
+MempoolStatus::mempool_stats::add(mempool_tx const& tx)
+{
+    fee_bucket& bucket = fee_histogram[bucket_index(fee_per_byte(tx))];
+
+    ++bucket.txs_no;
+    bucket.size   += tx.blob_size;
+    bucket.weight += tx.weight;
+    bucket.fee    += tx.fee;
+
+    ++txs_no;
+    total_size   += tx.blob_size;
+    total_weight += tx.weight;
+    total_fee    += tx.fee;
+}
+
+void
+MempoolStatus::mempool_stats::remove(mempool_tx const& tx)
+{
+    fee_bucket& bucket = fee_histogram[bucket_index(fee_per_byte(tx))];
+
+    --bucket.txs_no;
+    bucket.size   -= tx.blob_size;
+    bucket.weight -= tx.weight;
+    bucket.fee    -= tx.fee;
+
+    --txs_no;
+    total_size   -= tx.blob_size;
+    total_weight -= tx.weight;
+    total_fee    -= tx.fee;
+}
+
+uint64_t
+MempoolStatus::mempool_stats::fee_per_byte(mempool_tx const& tx)
+{
+    uint64_t bytes = tx.weight > 0 ? tx.weight : tx.blob_size;
+
+    return bytes > 0 ? tx.fee / bytes : 0;
+}
+
+size_t
+MempoolStatus::mempool_stats::bucket_index(uint64_t fee_per_byte)
+{
+    // last bucket whose lower bound is not greater than fee_per_byte
+    auto it = std::upper_bound(fee_per_byte_buckets.begin(),
+                               fee_per_byte_buckets.end(),
+                               fee_per_byte);
+
+    return std::distance(fee_per_byte_buckets.begin(), it) - 1;
+}
+
+bool
+MempoolStatus::mempool_snapshot::find_tx(crypto::hash const& tx_hash,
+                                         mempool_tx& found_tx) const
+{
+    auto it = rows_by_hash.find(tx_hash);
+
+    if (it == rows_by_hash.end())
+        return false;
+
+    found_tx = tx(it->second);
+
+    return true;
+}
+
+bool
+MempoolStatus::mempool_snapshot::find_tx_by_key_image(
+        crypto::key_image const& key_img, mempool_tx& found_tx) const
+{
+    auto it = rows_by_key_image.find(key_img);
+
+    if (it == rows_by_key_image.end())
+        return false;
 
-    no_of_tx = std::min<uint64_t>(no_of_tx, mempool_txs->size());
+    found_tx = tx(it->second);
+
+    return true;
+}
+
+MempoolStatus::mempool_full_tx::mempool_full_tx(
+        crypto::hash const& _tx_hash,
+        std::shared_ptr<const transaction> _tx)
+    : tx_hash {_tx_hash}, extra {_tx->extra}, tx {std::move(_tx)}
+{}
+
+vector<uint8_t> const&
+MempoolStatus::mempool_full_tx::get_extra() const
+{
+    return extra;
+}
+
+std::shared_ptr<const transaction>
+MempoolStatus::mempool_full_tx::get() const
+{
+    if (auto loaded_tx = std::atomic_load(&tx))
+        return loaded_tx;
 
-    // For partial access, we still need to create a new vector
-    // but this is rare and typically for small subsets
-    return std::make_shared<vector<mempool_tx>>(
-        mempool_txs->begin(), mempool_txs->begin() + no_of_tx);
+    // tx was dropped, so parse it again, but dont keep it,
+    // as it was dropped to save memory.
+    return load_mempool_tx(tx_hash);
+}
+
+void
+MempoolStatus::mempool_full_tx::drop() const
+{
+    std::atomic_store(&tx, std::shared_ptr<const transaction> {});
+}
+
+bool
+MempoolStatus::mempool_full_tx::is_loaded() const
+{
+    return static_cast<bool>(std::atomic_load(&tx));
+}
+
+std::shared_ptr<const transaction>
+MempoolStatus::mempool_tx::get_tx() const
+{
+    return full_tx ? full_tx->get() : nullptr;
+}
+
+shared_ptr<const string>
+MempoolStatus::mempool_snapshot::get_render(string const& key) const
+{
+    Guard lck (renders_mutx);
+
+    auto it = renders.find(key);
+
+    if (it == renders.end()
+            || it->second.wait_for(std::chrono::seconds(0))
+               != std::future_status::ready)
+    {
+        return nullptr;
+    }
+
+    return it->second.get();
+}
+
+shared_ptr<const string>
+MempoolStatus::mempool_snapshot::get_or_render(
+        string const& key, bool pinned,
+        std::function<string()> const& render,
+        bool& is_hit) const
+{
+    std::promise<shared_ptr<const string>> rendered_promise;
+
+    render_future rendered_future;
+
+    bool is_memoized {false};
+
+    {
+        Guard lck (renders_mutx);
+
+        auto it = renders.find(key);
+
+        if (it != renders.end())
+        {
+            rendered_future = it->second;
+        }
+        else if (pinned || no_of_unpinned_renders < max_no_of_renders)
+        {
+            renders.emplace(key, rendered_promise.get_future().share());
+
+            if (!pinned)
+                ++no_of_unpinned_renders;
+
+            is_memoized = true;
+        }
+    }
+
+    // rendered, or being rendered, by other request
+    if (rendered_future.valid())
+    {
+        is_hit = true;
+        return rendered_future.get();
+    }
+
+    is_hit = false;
+
+    if (!is_memoized)
+        return std::make_shared<const string>(render());
+
+    try
+    {
+        auto rendered = std::make_shared<const string>(render());
+
+        rendered_promise.set_value(rendered);
+
+        return rendered;
+    }
+    catch (...)
+    {
+        // requests waiting for it get the exception too,
+        // but next ones try to render it again
+        rendered_promise.set_exception(std::current_exception());
+
+        Guard lck (renders_mutx);
+
+        renders.erase(key);
+
+        if (!pinned)
+            --no_of_unpinned_renders;
+
+        throw;
+    }
 }
 
 bool
@@ -356,10 +853,11 @@ Blockchain*        MempoolStatus::core_storage {nullptr};
 xmreg::MicroCore*  MempoolStatus::mcore {nullptr};
 rpccalls::login_opt MempoolStatus::login {};
 std::unique_ptr<rpccalls> MempoolStatus::rpc_ptr {nullptr};
-MempoolStatus::mempool_txs_ptr MempoolStatus::mempool_txs {std::make_shared<vector<MempoolStatus::mempool_tx>>()};
+MempoolStatus::mempool_snapshot_ptr MempoolStatus::current_snapshot {std::make_shared<MempoolStatus::mempool_snapshot>()};
 atomic<MempoolStatus::network_info> MempoolStatus::current_network_info;
 atomic<uint64_t> MempoolStatus::mempool_no {0};   // no of txs
 atomic<uint64_t> MempoolStatus::mempool_size {0}; // size in bytes.
 uint64_t MempoolStatus::mempool_refresh_time {10};
+uint64_t MempoolStatus::max_full_txs_size {32 * 1024 * 1024};
 mutex MempoolStatus::mempool_mutx;
 }
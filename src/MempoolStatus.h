@@ -8,14 +8,18 @@
 
 #include "MicroCore.h"
 #include "rpccalls.h"
+#include "ChainNotifier.h"
 
 #include <boost/algorithm/string.hpp>
 
+#include <functional>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <unordered_map>
 
 namespace xmreg
 {
@@ -25,27 +29,70 @@ struct MempoolStatus
 
     using Guard = std::lock_guard<std::mutex>;
 
+    // Full tx of a mempool tx. During mempool floods, keeping
+    // all of them parsed takes a lot of memory, so they are kept
+    // only for the newest mempool txs (see max_full_txs_size). For
+    // older txs, they are dropped and parsed again from
+    // the txpool only when needed, e.g., to decode outputs.
+    // Pages and /api/mempool dont need them, as all they
+    // show is in the snapshot's columns and in tx extra,
+    // which is kept here even if the tx is dropped.
+    class mempool_full_tx
+    {
+        crypto::hash tx_hash;
+
+        // e.g., for payment ids, which /api/mempool shows
+        vector<uint8_t> extra;
+
+        // accessed only using std::atomic_load and std::atomic_store
+        mutable std::shared_ptr<const transaction> tx;
+
+    public:
+
+        mempool_full_tx(crypto::hash const& _tx_hash,
+                        std::shared_ptr<const transaction> _tx);
+
+        vector<uint8_t> const&
+        get_extra() const;
+
+        // returns nullptr if tx was dropped and
+        // in the meantime it left the mempool
+        std::shared_ptr<const transaction>
+        get() const;
+
+        void
+        drop() const;
+
+        bool
+        is_loaded() const;
+    };
+
+    using mempool_full_tx_ptr = std::shared_ptr<const mempool_full_tx>;
+
+    // Single mempool tx. Only numbers are kept here. Strings
+    // shown on pages, e.g., fee or timestamp, are formatted
+    // when the pages are rendered.
     struct mempool_tx
     {
         crypto::hash tx_hash;
-        transaction tx;
 
         uint64_t receive_time {0};
+        uint64_t fee {0};
+        uint64_t blob_size {0};
+        uint64_t weight {0};
         uint64_t sum_inputs {0};
         uint64_t sum_outputs {0};
-        uint64_t no_inputs {0};
-        uint64_t no_outputs {0};
-        uint64_t num_nonrct_inputs {0};
-        uint64_t mixin_no {0};
-
-        string fee_str;
-        string fee_micro_str;
-        string payed_for_kB_str;
-        string payed_for_kB_micro_str;
-        string xmr_inputs_str;
-        string xmr_outputs_str;
-        string timestamp_str;
-        string txsize;
+        uint32_t no_inputs {0};
+        uint32_t no_outputs {0};
+        uint32_t num_nonrct_inputs {0};
+        uint32_t mixin_no {0};
+        uint8_t  version {0};
+        uint8_t  rct_type {0};
+
+        mempool_full_tx_ptr full_tx;
+
+        std::shared_ptr<const transaction>
+        get_tx() const;
     };
 
 
@@ -137,12 +184,176 @@ struct MempoolStatus
     static MicroCore* mcore;
     static Blockchain* core_storage;
 
-    // Shared pointer to mempool transactions - uses copy-on-write pattern
+    // maximum size, in bytes, of blobs of the newest mempool
+    // txs for which full txs are kept parsed in memory
+    static uint64_t max_full_txs_size;
+
+    // Aggregated statistics of the mempool. They are not
+    // recalculated for each refresh, but updated only using
+    // txs that arrived to and left the mempool.
+    struct mempool_stats
+    {
+        // lower bounds of fee per byte buckets, in piconero.
+        // the fee is per tx weight, as this is what the daemon
+        // uses when it estimates fees.
+        static constexpr array<uint64_t, 14> fee_per_byte_buckets {
+            0, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+            200000, 500000, 1000000, 2000000, 5000000, 10000000};
+
+        struct fee_bucket
+        {
+            uint64_t txs_no {0};
+            uint64_t size {0};
+            uint64_t weight {0};
+            uint64_t fee {0};
+        };
+
+        array<fee_bucket, fee_per_byte_buckets.size()> fee_histogram;
+
+        uint64_t txs_no {0};
+        uint64_t total_size {0};
+        uint64_t total_weight {0};
+        uint64_t total_fee {0};
+
+        void
+        add(mempool_tx const& tx);
+
+        void
+        remove(mempool_tx const& tx);
+
+        static uint64_t
+        fee_per_byte(mempool_tx const& tx);
+
+        static size_t
+        bucket_index(uint64_t fee_per_byte);
+    };
+
+    // State of the mempool after a single refresh. Snapshots are
+    // never changed once published, so pages rendered from
+    // a snapshot, e.g., front page mempool fragment or /api/mempool
+    // json, are memoized in it and handed out to all requests made
+    // before the next refresh. New snapshot comes with empty renders.
+    //
+    // Txs are kept column-wise, sorted from the newest
+    // to the oldest one, so that rendering, e.g., only ages and fees
+    // of txs, touches only the memory it needs.
+    struct mempool_snapshot
+    {
+        // incremented with every refresh
+        uint64_t version {0};
+
+        // time when the snapshot was made
+        uint64_t timestamp {0};
+
+        // sum of blob sizes of its txs, in bytes. Pages rendered
+        // from the snapshot take it from here, not from mempool_size,
+        // which can be of a newer refresh already.
+        uint64_t size_bytes {0};
+
+        vector<crypto::hash>        tx_hashes;
+        vector<uint64_t>            receive_times;
+        vector<uint64_t>            fees;
+        vector<uint64_t>            blob_sizes;
+        vector<uint64_t>            weights;
+        vector<uint64_t>            sum_inputs;
+        vector<uint64_t>            sum_outputs;
+        vector<uint32_t>            no_inputs;
+        vector<uint32_t>            no_outputs;
+        vector<uint32_t>            num_nonrct_inputs;
+        vector<uint32_t>            mixin_nos;
+        vector<uint8_t>             versions;
+        vector<uint8_t>             rct_types;
+
+        // full txs are shared between consecutive snapshots,
+        // so that a tx which stays in the mempool is parsed only once.
+        vector<mempool_full_tx_ptr> full_txs;
+
+        // row of a tx in the columns above, for O(1) lookups.
+        // rows_by_hash is also used to find already parsed txs
+        // in the next refresh. Both are carried forward to the
+        // next snapshot, and only txs which arrived or left
+        // are added to or erased from them.
+        unordered_map<crypto::hash, size_t> rows_by_hash;
+
+        // key images of inputs of the txs, e.g., to check
+        // for double spends.
+        unordered_map<crypto::key_image, size_t> rows_by_key_image;
+
+        mempool_stats stats;
+
+        size_t
+        size() const;
+
+        bool
+        empty() const;
+
+        // tx at the given row, i.e., row 0 is the newest tx
+        mempool_tx
+        tx(size_t row) const;
+
+        // push_back and push_back_row dont update rows_by_hash
+        // and rows_by_key_image, read_mempool does it.
+        void
+        push_back(mempool_tx const& tx);
+
+        // row of other snapshot, e.g., of a tx which
+        // stayed in the mempool since the previous refresh
+        void
+        push_back_row(mempool_snapshot const& other, size_t row);
+
+        void
+        reserve(size_t no_of_txs);
+
+        // receive time of a tx at the given percentile of
+        // ages of txs in the snapshot, e.g., 0.5 gives
+        // receive time of the tx with the median age.
+        uint64_t
+        receive_time_percentile(double percentile) const;
+
+        bool
+        find_tx(crypto::hash const& tx_hash, mempool_tx& found_tx) const;
+
+        bool
+        find_tx_by_key_image(crypto::key_image const& key_img,
+                             mempool_tx& found_tx) const;
+
+        // to protect from flooding the memo with, e.g.,
+        // different page and limit values in /api/mempool.
+        // Pinned renders, e.g., of the front page or of the
+        // default /api/mempool, dont count towards it.
+        static constexpr size_t max_no_of_renders {64};
+
+        // nullptr if not rendered yet, or still being rendered
+        shared_ptr<const string>
+        get_render(string const& key) const;
+
+        // render is called only if the key was not rendered yet.
+        // Requests for the same key which come while it is
+        // rendered, wait for it instead of rendering it again.
+        // is_hit is false only for the request which rendered it.
+        shared_ptr<const string>
+        get_or_render(string const& key, bool pinned,
+                      std::function<string()> const& render,
+                      bool& is_hit) const;
+
+    private:
+
+        using render_future = std::shared_future<shared_ptr<const string>>;
+
+        mutable mutex renders_mutx;
+
+        mutable unordered_map<string, render_future> renders;
+
+        mutable size_t no_of_unpinned_renders {0};
+    };
+
+    using mempool_snapshot_ptr = std::shared_ptr<const mempool_snapshot>;
+
+    // Shared pointer to mempool snapshot - uses copy-on-write pattern
     // to avoid expensive deep copies when multiple request handlers access
     // the mempool simultaneously. Readers get a reference-counted pointer,
-    // writer creates a new vector and atomically swaps the pointer.
-    using mempool_txs_ptr = std::shared_ptr<vector<mempool_tx>>;
-    static mempool_txs_ptr mempool_txs;
+    // writer creates a new snapshot and atomically swaps the pointer.
+    static mempool_snapshot_ptr current_snapshot;
 
     static atomic<network_info> current_network_info;
 
@@ -156,16 +367,24 @@ struct MempoolStatus
     static bool
     read_mempool();
 
+    static bool
+    parse_mempool_tx(crypto::hash const& tx_hash,
+                     txpool_tx_meta_t const& meta,
+                     cryptonote::blobdata const& tx_blob,
+                     mempool_tx& parsed_tx);
+
+    // parse tx which is in the txpool, e.g., when its
+    // full tx was dropped. Returns nullptr if the tx is not
+    // in the txpool anymore.
+    static std::shared_ptr<const transaction>
+    load_mempool_tx(crypto::hash const& tx_hash);
+
     static bool
     read_network_info();
 
     // Returns shared pointer to mempool - cheap reference copy, no deep copy
-    static mempool_txs_ptr
-    get_mempool_txs();
-
-    // Returns first no_of_tx transactions (still uses shared_ptr internally)
-    static mempool_txs_ptr
-    get_mempool_txs(uint64_t no_of_tx);
+    static mempool_snapshot_ptr
+    get_mempool_snapshot();
 
     static bool
     is_thread_running();
@@ -0,0 +1,335 @@
+//
+// Created on 18/10/26.
+//
+
+#include "Metrics.h"
+
+#include <cstdio>
+#include <set>
+#include <sstream>
+
+namespace xmreg
+{
+
+void
+Metrics::histogram::observe(uint64_t value)
+{
+    size_t bucket {0};
+
+    if (bounds)
+    {
+        while (bucket < bounds->size() && value > (*bounds)[bucket])
+            ++bucket;
+    }
+
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+namespace
+{
+
+void
+init_value(Metrics::family<Metrics::counter>&, Metrics::counter&)
+{
+}
+
+void
+init_value(Metrics::family<Metrics::histogram>& f, Metrics::histogram& h)
+{
+    h.bounds = &f.bounds;
+}
+
+}
+
+template <typename T>
+T&
+Metrics::family<T>::get(string const& label)
+{
+    size_t no_of_labels = size.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < no_of_labels; ++i)
+        if (labels[i] == label)
+            return values[i];
+
+    std::lock_guard<std::mutex> lck (add_mutx);
+
+    // it could have been added in the meantime
+    no_of_labels = size.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < no_of_labels; ++i)
+        if (labels[i] == label)
+            return values[i];
+
+    // the last one is kept for "other", i.e., all
+    // labels which did not fit before it
+    if (no_of_labels == max_labels)
+        return values[max_labels - 1];
+
+    labels[no_of_labels] = (no_of_labels == max_labels - 1)
+                           ? string {"other"} : label;
+
+    init_value(*this, values[no_of_labels]);
+
+    size.store(no_of_labels + 1, std::memory_order_release);
+
+    return values[no_of_labels];
+}
+
+template struct Metrics::family<Metrics::counter>;
+template struct Metrics::family<Metrics::histogram>;
+
+vector<uint64_t> const Metrics::duration_bounds {
+        1000, 5000, 10000, 25000, 50000, 100000, 250000,
+        500000, 1000000, 2500000, 5000000, 10000000, 30000000};
+
+vector<uint64_t> const Metrics::size_bounds {
+        1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 10485760};
+
+Metrics::counter_family Metrics::http_requests {
+        "xmrblocks_http_requests_total",
+        "Number of http requests", "route"};
+
+Metrics::counter_family Metrics::http_responses {
+        "xmrblocks_http_responses_total",
+        "Number of http responses by status class", "code"};
+
+Metrics::histogram_family Metrics::http_request_duration {
+        "xmrblocks_http_request_duration_seconds",
+        "Time from reading a request to completing its response", "route",
+        duration_bounds, 1e-6};
+
+Metrics::histogram_family Metrics::http_response_size {
+        "xmrblocks_http_response_size_bytes",
+        "Size of response bodies", "route",
+        size_bounds};
+
+Metrics::counter_family Metrics::lmdb_reads {
+        "xmrblocks_lmdb_reads_total",
+        "Number of blockchain reads, by the call made", "call"};
+
+Metrics::histogram_family Metrics::rpc_call_duration {
+        "xmrblocks_rpc_call_duration_seconds",
+        "Duration of daemon rpc calls", "call",
+        duration_bounds, 1e-6};
+
+Metrics::counter_family Metrics::rpc_errors {
+        "xmrblocks_rpc_errors_total",
+        "Number of failed daemon rpc calls", "call"};
+
+Metrics::counter_family Metrics::cache_hits {
+        "xmrblocks_cache_hits_total",
+        "Number of results served from a cache", "cache"};
+
+Metrics::counter_family Metrics::cache_misses {
+        "xmrblocks_cache_misses_total",
+        "Number of results which had to be made", "cache"};
+
+Metrics::histogram_family Metrics::mempool_refresh_duration {
+        "xmrblocks_mempool_refresh_duration_seconds",
+        "Duration of reading the mempool", "",
+        duration_bounds, 1e-6};
+
+mutex Metrics::gauges_mutx;
+vector<Metrics::gauge_callback> Metrics::gauges;
+
+void
+Metrics::add_gauge(string const& name, string const& help,
+                   std::function<double()> read,
+                   string const& label_name,
+                   string const& label)
+{
+    std::lock_guard<std::mutex> lck (gauges_mutx);
+
+    gauges.push_back({name, help, label_name, label, std::move(read)});
+}
+
+void
+Metrics::add_counter(string const& name, string const& help,
+                     std::function<double()> read,
+                     string const& label_name,
+                     string const& label)
+{
+    std::lock_guard<std::mutex> lck (gauges_mutx);
+
+    gauges.push_back({name, help, label_name, label, std::move(read),
+                      "counter"});
+}
+
+void
+Metrics::add_cache_access(string const& cache, bool hit)
+{
+    (hit ? cache_hits : cache_misses).get(cache).inc();
+}
+
+uint64_t
+Metrics::elapsed_us(clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            clock::now() - start).count();
+}
+
+namespace
+{
+
+string
+escape_label(string const& label)
+{
+    string escaped;
+
+    for (char c: label)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+// {route="/tx"} or {route="/tx",le="0.5"}
+string
+labels_str(string const& label_name, string const& label,
+           string const& le = "")
+{
+    vector<string> pairs;
+
+    if (!label_name.empty())
+        pairs.push_back(label_name + "=\"" + escape_label(label) + "\"");
+
+    if (!le.empty())
+        pairs.push_back("le=\"" + le + "\"");
+
+    if (pairs.empty())
+        return "";
+
+    string s {"{"};
+
+    for (size_t i = 0; i < pairs.size(); ++i)
+        s += (i > 0 ? "," : "") + pairs[i];
+
+    return s + "}";
+}
+
+string
+number_str(double value)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+void
+write_header(ostringstream& out, string const& name,
+             string const& help, string const& type)
+{
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+void
+write_family(ostringstream& out, Metrics::counter_family& f)
+{
+    write_header(out, f.name, f.help, "counter");
+
+    size_t no_of_labels = f.size.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < no_of_labels; ++i)
+    {
+        out << f.name << labels_str(f.label_name, f.labels[i]) << " "
+            << f.values[i].value.load(std::memory_order_relaxed) << "\n";
+    }
+}
+
+void
+write_family(ostringstream& out, Metrics::histogram_family& f)
+{
+    write_header(out, f.name, f.help, "histogram");
+
+    size_t no_of_labels = f.size.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < no_of_labels; ++i)
+    {
+        Metrics::histogram const& h = f.values[i];
+
+        uint64_t cumulative {0};
+
+        for (size_t b = 0; b < f.bounds.size(); ++b)
+        {
+            cumulative += h.counts[b].load(std::memory_order_relaxed);
+
+            out << f.name << "_bucket"
+                << labels_str(f.label_name, f.labels[i],
+                              number_str(f.bounds[b] * f.scale))
+                << " " << cumulative << "\n";
+        }
+
+        cumulative += h.counts[f.bounds.size()].load(std::memory_order_relaxed);
+
+        out << f.name << "_bucket"
+            << labels_str(f.label_name, f.labels[i], "+Inf")
+            << " " << cumulative << "\n";
+
+        out << f.name << "_sum" << labels_str(f.label_name, f.labels[i]) << " "
+            << number_str(h.sum.load(std::memory_order_relaxed) * f.scale) << "\n";
+
+        // the same as the +Inf bucket, so that they agree
+        // even if something was observed in the meantime
+        out << f.name << "_count" << labels_str(f.label_name, f.labels[i]) << " "
+            << cumulative << "\n";
+    }
+}
+
+}
+
+string
+Metrics::render()
+{
+    ostringstream out;
+
+    write_family(out, http_requests);
+    write_family(out, http_responses);
+    write_family(out, http_request_duration);
+    write_family(out, http_response_size);
+    write_family(out, lmdb_reads);
+    write_family(out, rpc_call_duration);
+    write_family(out, rpc_errors);
+    write_family(out, cache_hits);
+    write_family(out, cache_misses);
+    write_family(out, mempool_refresh_duration);
+
+    std::lock_guard<std::mutex> lck (gauges_mutx);
+
+    // gauges of the same name can be added separately,
+    // e.g., for different labels, but header goes once
+    set<string> written;
+
+    for (gauge_callback const& g: gauges)
+    {
+        if (written.insert(g.name).second)
+        {
+            write_header(out, g.name, g.help, g.type);
+
+            for (gauge_callback const& same: gauges)
+            {
+                if (same.name != g.name)
+                    continue;
+
+                out << same.name << labels_str(same.label_name, same.label)
+                    << " " << number_str(same.read()) << "\n";
+            }
+        }
+    }
+
+    return out.str();
+}
+
+}
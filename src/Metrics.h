@@ -0,0 +1,178 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_METRICS_H
+#define XMRBLOCKS_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Counters and histograms of what the explorer does, e.g.,
+ * requests of each route, lmdb reads, daemon rpc calls or mempool
+ * refreshes, served at /metrics in Prometheus text format.
+ *
+ * Recording is lock-free: counters and histogram buckets are
+ * relaxed atomics, and labels, e.g., routes, are looked up
+ * in a fixed array which is only appended to. A mutex is taken
+ * only when a label is seen for the first time.
+ *
+ * Values which are already kept elsewhere, e.g., mempool size
+ * or compute queue depth, are not copied here. They are read
+ * by callbacks when /metrics is rendered. Callbacks of counters
+ * kept elsewhere, e.g., rejected requests, are added with
+ * add_counter, so that they are typed as counters.
+ */
+struct Metrics
+{
+    using clock = std::chrono::steady_clock;
+
+    struct counter
+    {
+        atomic<uint64_t> value {0};
+
+        void
+        inc(uint64_t n = 1)
+        {
+            value.fetch_add(n, std::memory_order_relaxed);
+        }
+    };
+
+    // Observations are integers, e.g., microseconds or bytes.
+    // They are shown multiplied by the scale of their family,
+    // e.g., 1e-6 for seconds.
+    struct histogram
+    {
+        static constexpr size_t max_buckets {16};
+
+        // upper bounds of buckets, without +Inf
+        vector<uint64_t> const* bounds {nullptr};
+
+        // observations in each bucket, not cumulative.
+        // The one after the last bound is +Inf
+        array<atomic<uint64_t>, max_buckets + 1> counts {};
+
+        atomic<uint64_t> sum {0};
+        atomic<uint64_t> count {0};
+
+        void
+        observe(uint64_t value);
+    };
+
+    template <typename T>
+    struct family
+    {
+        // labels over it are counted as "other"
+        static constexpr size_t max_labels {64};
+
+        string name;
+        string help;
+
+        // empty for a family with a single value
+        string label_name;
+
+        // only for histograms
+        vector<uint64_t> bounds;
+        double scale {1.0};
+
+        array<string, max_labels> labels;
+        array<T, max_labels> values;
+
+        // entries below it are never changed
+        atomic<size_t> size {0};
+
+        mutex add_mutx;
+
+        family(string _name, string _help, string _label_name = "",
+               vector<uint64_t> _bounds = {}, double _scale = 1.0)
+            : name {std::move(_name)},
+              help {std::move(_help)},
+              label_name {std::move(_label_name)},
+              bounds {std::move(_bounds)},
+              scale {_scale}
+        {}
+
+        T&
+        get(string const& label = "");
+    };
+
+    using counter_family   = family<counter>;
+    using histogram_family = family<histogram>;
+
+    // value of a gauge, or of a counter kept elsewhere,
+    // at the time of rendering
+    struct gauge_callback
+    {
+        string name;
+        string help;
+        string label_name;
+        string label;
+        std::function<double()> read;
+
+        // "gauge" or "counter"
+        string type {"gauge"};
+    };
+
+    // bounds in microseconds, from 1 ms to 30 s
+    static vector<uint64_t> const duration_bounds;
+
+    // bounds in bytes, from 1 kB to 10 MB
+    static vector<uint64_t> const size_bounds;
+
+    static counter_family   http_requests;
+    static counter_family   http_responses;
+    static histogram_family http_request_duration;
+    static histogram_family http_response_size;
+
+    static counter_family   lmdb_reads;
+
+    static histogram_family rpc_call_duration;
+    static counter_family   rpc_errors;
+
+    static counter_family   cache_hits;
+    static counter_family   cache_misses;
+
+    static histogram_family mempool_refresh_duration;
+
+    static mutex gauges_mutx;
+    static vector<gauge_callback> gauges;
+
+    static void
+    add_gauge(string const& name, string const& help,
+              std::function<double()> read,
+              string const& label_name = "",
+              string const& label = "");
+
+    // read must never decrease. name should end with _total
+    static void
+    add_counter(string const& name, string const& help,
+                std::function<double()> read,
+                string const& label_name = "",
+                string const& label = "");
+
+    static void
+    add_cache_access(string const& cache, bool hit);
+
+    // microseconds since start
+    static uint64_t
+    elapsed_us(clock::time_point start);
+
+    static string
+    render();
+};
+
+}
+
+#endif //XMRBLOCKS_METRICS_H
@@ -3,6 +3,8 @@
 //
 
 #include "MicroCore.h"
+#include "Metrics.h"
+#include "RequestTimings.h"
 
 
 namespace xmreg
@@ -43,9 +45,14 @@ MicroCore::~MicroCore()
  * Create BlockchainLMDB on the heap.
  * Open database files located in blockchain_path.
  * Initialize m_blockchain_storage with the BlockchainLMDB object.
+ *
+ * The explorer only reads the blockchain. read_only = false
+ * is for benchmarks which make their own, e.g., mempool
+ * in a temporary folder.
  */
 bool
-MicroCore::init(const string& _blockchain_path, network_type nt)
+MicroCore::init(const string& _blockchain_path, network_type nt,
+                bool read_only)
 {
     int db_flags = 0;
 
@@ -53,8 +60,11 @@ MicroCore::init(const string& _blockchain_path, network_type nt)
 
     nettype = nt;
 
-    db_flags |= MDB_RDONLY;
-    db_flags |= MDB_NOLOCK;
+    if (read_only)
+    {
+        db_flags |= MDB_RDONLY;
+        db_flags |= MDB_NOLOCK;
+    }
 
     BlockchainDB* db = nullptr;
     db = new BlockchainLMDB();
@@ -104,6 +114,12 @@ MicroCore::get_mempool()
 bool
 MicroCore::get_block_by_height(const uint64_t& height, block& blk)
 {
+    static Metrics::counter& reads = Metrics::lmdb_reads.get("get_block_by_height");
+
+    reads.inc();
+
+    RequestTimings::phase timer {RequestTimings::db};
+
     try
     {
         blk = m_blockchain_storage.get_db().get_block_from_height(height);
@@ -144,6 +160,12 @@ MicroCore::get_block_by_height(const uint64_t& height, block& blk)
 bool
 MicroCore::get_tx(const crypto::hash& tx_hash, transaction& tx)
 {
+    static Metrics::counter& reads = Metrics::lmdb_reads.get("get_tx");
+
+    reads.inc();
+
+    RequestTimings::phase timer {RequestTimings::db};
+
     if (m_blockchain_storage.have_tx(tx_hash))
     {
         // get transaction with given hash
@@ -40,7 +40,8 @@ namespace xmreg
         ~MicroCore();
 
         bool
-        init(const string& _blockchain_path, network_type nt);
+        init(const string& _blockchain_path, network_type nt,
+             bool read_only = true);
 
         Blockchain&
         get_core();
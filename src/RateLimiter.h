@@ -0,0 +1,244 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_RATELIMITER_H
+#define XMRBLOCKS_RATELIMITER_H
+
+#include "AdmissionControl.h"
+
+#include "../ext/crow_all.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Crow middleware limiting how many requests a single client
+ * can make, with a token bucket per client address.
+ *
+ * Each bucket holds up to burst tokens and refills at rate tokens
+ * per second. A request takes one token, or heavy_cost tokens for
+ * expensive routes (the same ones as in AdmissionControl), so
+ * scrapers of cheap pages are not limited as much as those of
+ * decoded outputs. Clients without enough tokens get 429 with
+ * Retry-After, before any blockchain work is done.
+ *
+ * If the client address is a trusted proxy, e.g., local nginx
+ * or Tor, the client is the last address in X-Forwarded-For
+ * which is not a trusted proxy. Connections over unix socket
+ * have no address and always come from a trusted proxy.
+ *
+ * Buckets are split into shards, each with its own mutex, so that
+ * crow threads rarely wait for each other. Full buckets, i.e., of
+ * clients idle for a while, are removed from time to time.
+ */
+struct RateLimiter
+{
+    using clock = std::chrono::steady_clock;
+
+    struct context
+    {
+    };
+
+    struct bucket
+    {
+        double tokens {0};
+        clock::time_point last_refill;
+    };
+
+    struct shard
+    {
+        std::mutex shard_mutx;
+
+        unordered_map<string, bucket> buckets;
+
+        // requests since idle buckets were last removed
+        uint64_t no_of_requests {0};
+    };
+
+    static constexpr size_t no_of_shards {64};
+
+    // how often, in requests, a shard removes idle buckets
+    static constexpr uint64_t eviction_interval {4096};
+
+    // tokens per second. 0 means no limit
+    double rate {0};
+
+    double burst {0};
+
+    double heavy_cost {10};
+
+    set<string> trusted_proxies;
+
+    std::atomic<uint64_t> no_limited {0};
+
+    // 0 burst means 5 seconds worth of tokens
+    void
+    set_limits(double _rate,
+               double _burst,
+               double _heavy_cost,
+               set<string> _trusted_proxies = {})
+    {
+        rate            = _rate;
+        burst           = _burst > 0 ? _burst : 5 * _rate;
+        heavy_cost      = std::max(1.0, _heavy_cost);
+        trusted_proxies = std::move(_trusted_proxies);
+    }
+
+    string
+    get_client_address(crow::request const& req) const
+    {
+        string const& remote_address = req.remote_ip_address;
+
+        if (!remote_address.empty()
+                && trusted_proxies.count(remote_address) == 0)
+            return remote_address;
+
+        string forwarded_for = req.get_header_value("X-Forwarded-For");
+
+        string client_address = remote_address;
+
+        // each proxy appends the address it got the request from,
+        // so go from the right, past our own proxies
+        size_t end = forwarded_for.size();
+
+        while (end > 0)
+        {
+            size_t comma = forwarded_for.rfind(',', end - 1);
+            size_t start = (comma == string::npos) ? 0 : comma + 1;
+
+            string address = forwarded_for.substr(start, end - start);
+
+            boost::trim(address);
+
+            if (!address.empty())
+            {
+                client_address = address;
+
+                if (trusted_proxies.count(address) == 0)
+                    break;
+            }
+
+            if (comma == string::npos)
+                break;
+
+            end = comma;
+        }
+
+        return client_address;
+    }
+
+    // false if the client has not enough tokens. retry_after
+    // is then the number of seconds until it will have
+    bool
+    take_tokens(string const& client_address,
+                double cost,
+                uint64_t& retry_after)
+    {
+        // a request must be possible with a full bucket
+        cost = std::min(cost, burst);
+
+        shard& s = shards[std::hash<string>{}(client_address) % no_of_shards];
+
+        clock::time_point now = clock::now();
+
+        std::lock_guard<std::mutex> lck (s.shard_mutx);
+
+        if (++s.no_of_requests % eviction_interval == 0)
+            remove_idle_buckets(s, now);
+
+        auto it = s.buckets.find(client_address);
+
+        if (it == s.buckets.end())
+        {
+            it = s.buckets.emplace(client_address,
+                                   bucket {burst, now}).first;
+        }
+
+        bucket& b = it->second;
+
+        double elapsed = std::chrono::duration<double>(
+                now - b.last_refill).count();
+
+        b.tokens      = std::min(burst, b.tokens + elapsed * rate);
+        b.last_refill = now;
+
+        if (b.tokens < cost)
+        {
+            retry_after = static_cast<uint64_t>(
+                    std::ceil((cost - b.tokens) / rate));
+            return false;
+        }
+
+        b.tokens -= cost;
+
+        return true;
+    }
+
+    void
+    before_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        if (rate <= 0)
+            return;
+
+        double cost = AdmissionControl::is_heavy_route(req.url)
+                      ? heavy_cost : 1;
+
+        uint64_t retry_after {1};
+
+        if (take_tokens(get_client_address(req), cost, retry_after))
+            return;
+
+        ++no_limited;
+
+        res.code = 429;
+        res.set_header("Retry-After",
+                       std::to_string(std::max<uint64_t>(1, retry_after)));
+        res.set_header("Content-Type", "text/plain");
+        res.body = "Too many requests. Please try again later.";
+        res.end();
+    }
+
+    void
+    after_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+    }
+
+private:
+
+    // buckets which refilled by now are the same as new ones
+    void
+    remove_idle_buckets(shard& s, clock::time_point now)
+    {
+        auto time_to_refill = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(burst / rate));
+
+        for (auto it = s.buckets.begin(); it != s.buckets.end();)
+        {
+            if (now - it->second.last_refill >= time_to_refill)
+                it = s.buckets.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    array<shard, no_of_shards> shards;
+};
+
+}
+
+#endif //XMRBLOCKS_RATELIMITER_H
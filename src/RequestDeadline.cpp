@@ -0,0 +1,33 @@
+//
+// Created on 18/10/26.
+//
+
+#include "RequestDeadline.h"
+
+namespace xmreg
+{
+
+uint64_t RequestDeadline::request_timeout {30000};
+
+thread_local RequestDeadline::clock::time_point
+        RequestDeadline::current_deadline {clock::time_point::max()};
+
+bool
+RequestDeadline::expired()
+{
+    return current_deadline != clock::time_point::max()
+           && clock::now() > current_deadline;
+}
+
+RequestDeadline::scope::scope(clock::time_point deadline)
+    : previous_deadline {current_deadline}
+{
+    current_deadline = deadline;
+}
+
+RequestDeadline::scope::~scope()
+{
+    current_deadline = previous_deadline;
+}
+
+}
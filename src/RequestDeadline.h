@@ -0,0 +1,53 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_REQUESTDEADLINE_H
+#define XMRBLOCKS_REQUESTDEADLINE_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace xmreg
+{
+
+/**
+ * Deadline of the request handled by the current thread.
+ *
+ * ComputeExecutor sets it before running an expensive handler.
+ * Long loops, e.g., over inputs and their ring members or over
+ * outputs to check, call RequestDeadline::expired() between
+ * iterations, and stop with a partial or timeout response,
+ * instead of keeping a thread busy for a client which is
+ * most likely gone.
+ *
+ * Threads without a deadline, e.g., crow threads handling
+ * cheap routes, never expire.
+ */
+struct RequestDeadline
+{
+    using clock = std::chrono::steady_clock;
+
+    // time, in milliseconds, expensive requests can take.
+    // 0 means no limit.
+    static uint64_t request_timeout;
+
+    static thread_local clock::time_point current_deadline;
+
+    static bool
+    expired();
+
+    // sets deadline of the current thread for the lifetime of the scope
+    struct scope
+    {
+        explicit scope(clock::time_point deadline);
+
+        ~scope();
+
+        clock::time_point previous_deadline;
+    };
+};
+
+}
+
+#endif //XMRBLOCKS_REQUESTDEADLINE_H
@@ -0,0 +1,106 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_REQUESTMETRICS_H
+#define XMRBLOCKS_REQUESTMETRICS_H
+
+#include "Metrics.h"
+
+#include "../ext/crow_all.h"
+
+#include <set>
+#include <string>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Crow middleware counting requests, their durations and response
+ * sizes for each route, and responses for each status class,
+ * e.g., 2xx or 5xx.
+ *
+ * It goes before other middlewares, so that requests limited
+ * or rejected by them are counted as well.
+ *
+ * Routes are labeled by their first segment, e.g., /tx or /block,
+ * or two for json api, e.g., /api/outputs, not by full urls,
+ * which would make a label of each tx hash. Unknown segments,
+ * e.g., of 404 pages, are all "other".
+ */
+struct RequestMetrics
+{
+    struct context
+    {
+        Metrics::clock::time_point start;
+    };
+
+    static string
+    route_label(string const& url)
+    {
+        static const set<string> routes {
+                "/", "/page", "/block", "/randomx", "/tx",
+                "/txhex", "/ringmembershex", "/ringmemberstxhex",
+                "/blockhex", "/blockhexcomplete", "/myoutputs",
+                "/prove", "/rawtx", "/checkandpush", "/rawkeyimgs",
+                "/checkrawkeyimgs", "/rawoutputkeys",
+                "/checkrawoutputkeys", "/search", "/mempool",
+                "/txpool", "/altblocks", "/robots.txt",
+                "/autorefresh", "/live", "/metrics"};
+
+        static const set<string> api_routes {
+                "/api/transaction", "/api/rawtransaction",
+                "/api/detailedtransaction", "/api/block",
+                "/api/rawblock", "/api/transactions", "/api/mempool",
+                "/api/mempoolstats", "/api/search", "/api/networkinfo",
+                "/api/emission", "/api/outputs", "/api/outputsblocks",
+                "/api/chainstats", "/api/version"};
+
+        size_t end = url.find('/', 1);
+
+        string label = url.substr(0, end);
+
+        if (label == "/api" && end != string::npos)
+        {
+            label = url.substr(0, url.find('/', end + 1));
+            return api_routes.count(label) ? label : "other";
+        }
+
+        return routes.count(label) ? label : "other";
+    }
+
+    static string
+    status_class(int code)
+    {
+        return code >= 100 && code < 600
+               ? std::to_string(code / 100) + "xx"
+               : "other";
+    }
+
+    void
+    before_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        ctx.start = Metrics::clock::now();
+    }
+
+    void
+    after_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        string route = route_label(req.url);
+
+        Metrics::http_requests.get(route).inc();
+
+        Metrics::http_request_duration.get(route)
+                .observe(Metrics::elapsed_us(ctx.start));
+
+        Metrics::http_response_size.get(route).observe(res.body.size());
+
+        Metrics::http_responses.get(status_class(res.code)).inc();
+    }
+};
+
+}
+
+#endif //XMRBLOCKS_REQUESTMETRICS_H
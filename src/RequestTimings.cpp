@@ -0,0 +1,134 @@
+//
+// Created on 18/10/26.
+//
+
+#include "RequestTimings.h"
+
+#include "../ext/fmt/format.h"
+
+namespace xmreg
+{
+
+array<char const*, RequestTimings::no_of_phases> const
+        RequestTimings::phase_names {
+                "queue", "db", "decode", "tx_details",
+                "rings", "render", "serialize"};
+
+uint64_t RequestTimings::slow_request_time {0};
+
+bool RequestTimings::enable_server_timing {false};
+
+thread_local RequestTimings::record*
+        RequestTimings::current_record {nullptr};
+
+namespace
+{
+
+double
+to_ms(RequestTimings::clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+void
+RequestTimings::record::add(phase_id id, clock::duration duration)
+{
+    durations[id] += duration;
+    ++counts[id];
+}
+
+string
+RequestTimings::record::server_timing(clock::duration total) const
+{
+    string header;
+
+    for (size_t i = 0; i < no_of_phases; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        header += fmt::format("{:s};dur={:.3f}, ",
+                              phase_names[i], to_ms(durations[i]));
+    }
+
+    return header + fmt::format("total;dur={:.3f}", to_ms(total));
+}
+
+string
+RequestTimings::record::summary() const
+{
+    string s;
+
+    for (size_t i = 0; i < no_of_phases; ++i)
+    {
+        if (counts[i] == 0)
+            continue;
+
+        s += fmt::format("{:s}{:s} {:.1f} ms ({:d})",
+                         s.empty() ? "" : ", ",
+                         phase_names[i], to_ms(durations[i]), counts[i]);
+    }
+
+    return s;
+}
+
+bool
+RequestTimings::enabled()
+{
+    return enable_server_timing || slow_request_time > 0;
+}
+
+RequestTimings::scope::scope(record* _record)
+    : previous_record {current_record}
+{
+    current_record = _record;
+}
+
+RequestTimings::scope::~scope()
+{
+    current_record = previous_record;
+}
+
+RequestTimings::phase::phase(phase_id _id)
+    : id {_id}, rec {current_record}
+{
+    if (!rec)
+        return;
+
+    start = clock::now();
+
+    outer = rec->active;
+
+    // outer phase is paused until this one stops
+    if (outer)
+        rec->durations[outer->id] += start - outer->start;
+
+    rec->active = this;
+}
+
+RequestTimings::phase::~phase()
+{
+    stop();
+}
+
+void
+RequestTimings::phase::stop()
+{
+    if (!rec)
+        return;
+
+    clock::time_point now = clock::now();
+
+    rec->add(id, now - start);
+
+    rec->active = outer;
+
+    if (outer)
+        outer->start = now;
+
+    rec = nullptr;
+}
+
+}
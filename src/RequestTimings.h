@@ -0,0 +1,116 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_REQUESTTIMINGS_H
+#define XMRBLOCKS_REQUESTTIMINGS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Time spent in each phase of the request handled by the current
+ * thread, e.g., reading lmdb, resolving ring members or rendering
+ * templates.
+ *
+ * Code of a phase is marked with a scoped phase timer. Timers do
+ * nothing if the thread has no record, i.e., when Server-Timing
+ * and slow request logging are both off, or for work which is
+ * not of any request, e.g., the mempool thread.
+ *
+ * Phases can be nested, e.g., lmdb reads of ring members. Time is
+ * then counted only for the inner one, and the outer one is
+ * paused, so that phases add up to no more than the request took.
+ */
+struct RequestTimings
+{
+    using clock = std::chrono::steady_clock;
+
+    enum phase_id
+    {
+        queue,      // waiting for a compute thread
+        db,         // reading blocks and txs from lmdb
+        decode,     // parsing tx blobs and decoding outputs with viewkeys
+        tx_details, // get_tx_details
+        rings,      // resolving ring members of inputs
+        render,     // mstch templates
+        serialize,  // dumping json
+        no_of_phases
+    };
+
+    static array<char const*, no_of_phases> const phase_names;
+
+    struct phase;
+
+    struct record
+    {
+        array<clock::duration, no_of_phases> durations {};
+        array<uint64_t, no_of_phases> counts {};
+
+        // innermost phase running now
+        phase* active {nullptr};
+
+        void
+        add(phase_id id, clock::duration duration);
+
+        // e.g., db;dur=12.5, render;dur=3.1, total;dur=20.2
+        string
+        server_timing(clock::duration total) const;
+
+        // e.g., db 12.5 ms (340), render 3.1 ms (1)
+        string
+        summary() const;
+    };
+
+    // time, in milliseconds, over which requests are logged.
+    // 0 means they are not logged.
+    static uint64_t slow_request_time;
+
+    static bool enable_server_timing;
+
+    static thread_local record* current_record;
+
+    static bool
+    enabled();
+
+    // sets record of the current thread for the lifetime of the scope
+    struct scope
+    {
+        explicit scope(record* _record);
+
+        ~scope();
+
+        record* previous_record;
+    };
+
+    // counts time from its construction to its destruction,
+    // or to stop(), in the record of the current thread
+    struct phase
+    {
+        explicit phase(phase_id _id);
+
+        ~phase();
+
+        phase(phase const&) = delete;
+        phase& operator=(phase const&) = delete;
+
+        void
+        stop();
+
+        phase_id id;
+        record* rec;
+        phase* outer {nullptr};
+        clock::time_point start;
+    };
+};
+
+}
+
+#endif //XMRBLOCKS_REQUESTTIMINGS_H
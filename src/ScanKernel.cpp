@@ -0,0 +1,179 @@
+//
+// Created on 18/10/26.
+//
+
+#include "ScanKernel.h"
+
+#include <cstring>
+
+namespace xmreg
+{
+
+namespace
+{
+
+// fe is a plain array, so wrap it to be able
+// to keep field elements in a vector
+struct fe_elem
+{
+    fe v;
+};
+
+}
+
+ScanKernel::ScanKernel(public_key const& spend_public_key)
+{
+    ge_p3 spend_point;
+
+    if (ge_frombytes_vartime(&spend_point,
+            reinterpret_cast<const unsigned char*>(&spend_public_key)) != 0)
+    {
+        cerr << "ScanKernel: spend public key is not a valid point" << endl;
+        return;
+    }
+
+    ge_p3_to_cached(&m_spend_public_key_cached, &spend_point);
+
+    m_valid = true;
+}
+
+bool
+ScanKernel::is_valid() const
+{
+    return m_valid;
+}
+
+bool
+ScanKernel::generate_key_derivations(vector<public_key> const& tx_pub_keys,
+                                     secret_key const& view_key,
+                                     vector<key_derivation>& derivations)
+{
+    const unsigned char* view_key_bytes
+            = reinterpret_cast<const unsigned char*>(&unwrap(unwrap(view_key)));
+
+    vector<ge_p2> points(tx_pub_keys.size());
+
+    for (size_t i = 0; i < tx_pub_keys.size(); ++i)
+    {
+        ge_p3 tx_pub_key_point;
+
+        if (ge_frombytes_vartime(&tx_pub_key_point,
+                reinterpret_cast<const unsigned char*>(&tx_pub_keys[i])) != 0)
+        {
+            return false;
+        }
+
+        ge_p2 shared_point;
+        ge_p1p1 shared_point_mul8;
+
+        ge_scalarmult(&shared_point, view_key_bytes, &tx_pub_key_point);
+        ge_mul8(&shared_point_mul8, &shared_point);
+        ge_p1p1_to_p2(&points[i], &shared_point_mul8);
+    }
+
+    batch_to_bytes(points, derivations);
+
+    return true;
+}
+
+bool
+ScanKernel::derive_public_keys(vector<key_derivation> const& derivations,
+                               vector<uint64_t> const& output_indices,
+                               vector<public_key>& derived_keys) const
+{
+    if (!m_valid || derivations.size() != output_indices.size())
+        return false;
+
+    vector<ge_p2> points(derivations.size());
+
+    for (size_t i = 0; i < derivations.size(); ++i)
+    {
+        ec_scalar scalar;
+
+        crypto::derivation_to_scalar(derivations[i], output_indices[i], scalar);
+
+        ge_p3 scalar_point;
+        ge_p1p1 sum_point;
+
+        ge_scalarmult_base(&scalar_point,
+                           reinterpret_cast<const unsigned char*>(&scalar));
+        ge_add(&sum_point, &scalar_point, &m_spend_public_key_cached);
+        ge_p1p1_to_p2(&points[i], &sum_point);
+    }
+
+    batch_to_bytes(points, derived_keys);
+
+    return true;
+}
+
+template <typename POD>
+void
+ScanKernel::batch_to_bytes(vector<ge_p2> const& points, vector<POD>& out)
+{
+    static_assert(sizeof(POD) == 32, "POD must be a 32 byte point");
+
+    size_t no_points = points.size();
+
+    out.resize(no_points);
+
+    if (no_points == 0)
+        return;
+
+    // running products of Z coordinates:
+    // z_products[i] = Z_0 * Z_1 * ... * Z_i
+    vector<fe_elem> z_products(no_points);
+
+    memcpy(z_products[0].v, points[0].Z, sizeof(fe));
+
+    for (size_t i = 1; i < no_points; ++i)
+        fe_mul(z_products[i].v, z_products[i - 1].v, points[i].Z);
+
+    // the only inversion for the whole batch
+    fe inv;
+    fe_invert(inv, z_products[no_points - 1].v);
+
+    for (size_t i = no_points; i-- > 0;)
+    {
+        fe z_inv;
+
+        if (i > 0)
+        {
+            fe next_inv;
+
+            fe_mul(z_inv, inv, z_products[i - 1].v);
+            fe_mul(next_inv, inv, points[i].Z);
+
+            memcpy(inv, next_inv, sizeof(fe));
+        }
+        else
+        {
+            memcpy(z_inv, inv, sizeof(fe));
+        }
+
+        // the same as ge_tobytes, but with precomputed 1/Z
+        fe x, y;
+
+        fe_mul(x, points[i].X, z_inv);
+        fe_mul(y, points[i].Y, z_inv);
+
+        unsigned char x_bytes[32];
+
+        unsigned char* s = reinterpret_cast<unsigned char*>(&out[i]);
+
+        fe_tobytes(s, y);
+        fe_tobytes(x_bytes, x);
+
+        s[31] ^= (x_bytes[0] & 1) << 7;
+    }
+}
+
+// explicit instantiations of batch_to_bytes template function
+template void
+ScanKernel::batch_to_bytes<key_derivation>(vector<ge_p2> const& points,
+                                           vector<key_derivation>& out);
+
+template void
+ScanKernel::batch_to_bytes<public_key>(vector<ge_p2> const& points,
+                                       vector<public_key>& out);
+
+}
@@ -0,0 +1,79 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_SCANKERNEL_H
+#define XMRBLOCKS_SCANKERNEL_H
+
+#include "monero_headers.h"
+
+#include <vector>
+
+namespace xmreg
+{
+
+using namespace cryptonote;
+using namespace crypto;
+using namespace std;
+
+/**
+ * Batched version of generate_key_derivation and
+ * derive_public_key used when scanning many outputs
+ * for a single address, e.g., in find_our_outputs.
+ *
+ * The spend public key is decompressed and converted
+ * into its cached (precomputed) form only once, when the
+ * kernel is constructed. The resulting points of a batch
+ * are compressed using a single field inversion
+ * (Montgomery's batch inversion trick), instead of one
+ * inversion per point as done by ge_tobytes.
+ *
+ * Results are bit for bit the same as of the generic
+ * crypto::generate_key_derivation and crypto::derive_public_key.
+ */
+class ScanKernel
+{
+    ge_cached m_spend_public_key_cached;
+
+    bool m_valid {false};
+
+public:
+
+    explicit ScanKernel(public_key const& spend_public_key);
+
+    bool
+    is_valid() const;
+
+    /**
+     * derivations[i] = 8 * view_key * tx_pub_keys[i]
+     *
+     * returns false if any of tx_pub_keys is not a valid point
+     */
+    static bool
+    generate_key_derivations(vector<public_key> const& tx_pub_keys,
+                             secret_key const& view_key,
+                             vector<key_derivation>& derivations);
+
+    /**
+     * derived_keys[i] = Hs(derivations[i] || output_indices[i]) * G
+     *                   + spend_public_key
+     *
+     * derivations and output_indices must be of the same size
+     */
+    bool
+    derive_public_keys(vector<key_derivation> const& derivations,
+                       vector<uint64_t> const& output_indices,
+                       vector<public_key>& derived_keys) const;
+
+    /**
+     * Compress points into their 32 byte representation
+     * using one field inversion for the whole batch.
+     */
+    template <typename POD>
+    static void
+    batch_to_bytes(vector<ge_p2> const& points, vector<POD>& out);
+};
+
+}
+
+#endif //XMRBLOCKS_SCANKERNEL_H
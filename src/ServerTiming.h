@@ -0,0 +1,81 @@
+//
+// Created on 18/10/26.
+//
+
+#ifndef XMRBLOCKS_SERVERTIMING_H
+#define XMRBLOCKS_SERVERTIMING_H
+
+#include "RequestTimings.h"
+
+#include "../ext/crow_all.h"
+
+#include <iostream>
+
+namespace xmreg
+{
+
+using namespace std;
+
+/**
+ * Crow middleware giving each request a RequestTimings record.
+ *
+ * Phases are sent back in Server-Timing header, so that they
+ * are shown by browser dev tools, if enable_server_timing is set.
+ * Requests which took longer than slow_request_time are logged
+ * with their phases.
+ *
+ * Sync handlers run on the crow thread between before_handle and
+ * after_handle, so the record is set for that thread here.
+ * ComputeExecutor sets it for its own thread for the expensive ones.
+ */
+struct ServerTiming
+{
+    struct context
+    {
+        RequestTimings::clock::time_point start;
+        RequestTimings::record record;
+        bool is_set {false};
+    };
+
+    void
+    before_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        // websocket upgrades never get to after_handle
+        if (!RequestTimings::enabled() || req.upgrade)
+            return;
+
+        ctx.start  = RequestTimings::clock::now();
+        ctx.is_set = true;
+
+        RequestTimings::current_record = &ctx.record;
+    }
+
+    void
+    after_handle(crow::request& req, crow::response& res, context& ctx)
+    {
+        if (!ctx.is_set)
+            return;
+
+        if (RequestTimings::current_record == &ctx.record)
+            RequestTimings::current_record = nullptr;
+
+        auto total = RequestTimings::clock::now() - ctx.start;
+
+        if (RequestTimings::enable_server_timing)
+            res.set_header("Server-Timing", ctx.record.server_timing(total));
+
+        if (RequestTimings::slow_request_time > 0
+                && total > std::chrono::milliseconds {
+                        RequestTimings::slow_request_time})
+        {
+            cout << "Slow request " << req.url << ": "
+                 << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         total).count() << " ms, "
+                 << ctx.record.summary() << endl;
+        }
+    }
+};
+
+}
+
+#endif //XMRBLOCKS_SERVERTIMING_H
@@ -25,7 +25,12 @@
 #include "rpccalls.h"
 
 #include "CurrentBlockchainStatus.h"
+#include "ChainStats.h"
 #include "MempoolStatus.h"
+#include "ScanKernel.h"
+#include "RequestDeadline.h"
+#include "Metrics.h"
+#include "RequestTimings.h"
 
 #include "../ext/crow_all.h"
 
@@ -74,6 +79,7 @@ inline thread_local RandomXThreadCleanup rx_thread_cleanup;
 #define TMPL_DIR                    "./templates"
 #define TMPL_PARIALS_DIR            TMPL_DIR "/partials"
 #define TMPL_CSS_STYLES             TMPL_DIR "/css/style.css"
+#define TMPL_LIVE_UPDATES_JS        TMPL_DIR "/js/live_updates.js"
 #define TMPL_INDEX                  TMPL_DIR "/index.html"
 #define TMPL_INDEX2                 TMPL_DIR "/index2.html"
 #define TMPL_MEMPOOL                TMPL_DIR "/mempool.html"
@@ -474,8 +480,17 @@ struct tx_details
 class page
 {
 
+// times private parts, e.g., get_tx_details, see bench/xmrblocks_bench.cpp
+friend struct page_bench;
+
 static const bool FULL_AGE_FORMAT {true};
 
+// percentiles of ages of mempool txs shown
+// on mempool page and in api/mempoolstats
+static inline const vector<pair<string, double>> mempool_age_percentiles {
+        {"p10", 0.10}, {"p25", 0.25}, {"p50", 0.50},
+        {"p75", 0.75}, {"p90", 0.90}, {"max", 1.0}};
+
 MicroCore* mcore;
 Blockchain* core_storage;
 rpccalls rpc;
@@ -500,6 +515,7 @@ bool enable_as_hex;
 bool enable_mixin_guess;
 
 bool enable_autorefresh_option;
+bool enable_live_updates;
 
 uint64_t no_of_mempool_tx_of_frontpage;
 uint64_t no_blocks_on_index;
@@ -519,6 +535,22 @@ string js_html_files_all_in_one;
 // read operation in OS
 map<string, string> template_file;
 
+struct alt_block_info
+{
+    string   hash;
+    int64_t  height {-1};
+    uint64_t timestamp {0};
+    int64_t  no_of_txs {-1};
+};
+
+// alt blocks are reused until the chain tip
+// or the number of alt blocks changes
+mutex alt_blocks_mutx;
+bool alt_blocks_cached {false};
+crypto::hash alt_blocks_tip {crypto::null_hash};
+uint64_t alt_blocks_count {0};
+vector<alt_block_info> alt_blocks_cache;
+
 public:
 
 page(MicroCore* _mcore,
@@ -531,6 +563,7 @@ page(MicroCore* _mcore,
      bool _enable_key_image_checker,
      bool _enable_output_key_checker,
      bool _enable_autorefresh_option,
+     bool _enable_live_updates,
      bool _enable_mixins_details,
      bool _enable_mixin_guess,
      uint64_t _no_blocks_on_index,
@@ -550,6 +583,7 @@ page(MicroCore* _mcore,
           enable_key_image_checker {_enable_key_image_checker},
           enable_output_key_checker {_enable_output_key_checker},
           enable_autorefresh_option {_enable_autorefresh_option},
+          enable_live_updates {_enable_live_updates},
           enable_mixins_details {_enable_mixins_details},
           enable_mixin_guess {_enable_mixin_guess},
           no_blocks_on_index {_no_blocks_on_index},
@@ -568,6 +602,10 @@ page(MicroCore* _mcore,
     // into template_file map
 
     template_file["css_styles"]      = xmreg::read(TMPL_CSS_STYLES);
+
+    if (enable_live_updates)
+        template_file["live_updates_js"] = xmreg::read(TMPL_LIVE_UPDATES_JS);
+
     template_file["header"]          = xmreg::read(TMPL_HEADER);
     template_file["footer"]          = get_footer();
     template_file["index2"]          = get_full_page(xmreg::read(TMPL_INDEX2));
@@ -602,12 +640,27 @@ page(MicroCore* _mcore,
 string
 index2(uint64_t page_no = 0, bool refresh_page = false)
 {
-    // get mempool for the front page also using async future
-    std::future<string> mempool_ftr = std::async(std::launch::async, [&]
+    // mempool for the front page is rendered only once
+    // for each mempool snapshot. So only if it was not
+    // rendered yet, we do it now using async future
+    shared_ptr<const string> mempool_html_rendered
+            = MempoolStatus::get_mempool_snapshot()->get_render(
+                    mempool_render_key(false, no_of_mempool_tx_of_frontpage));
+
+    std::future<string> mempool_ftr;
+
+    // misses are counted by mempool() itself
+    if (mempool_html_rendered)
+        Metrics::add_cache_access("mempool_html", true);
+
+    if (!mempool_html_rendered)
     {
-        // get memory pool rendered template
-        return mempool(false, no_of_mempool_tx_of_frontpage);
-    });
+        mempool_ftr = std::async(std::launch::async, [&]
+        {
+            // get memory pool rendered template
+            return mempool(false, no_of_mempool_tx_of_frontpage);
+        });
+    }
 
     //get current server timestamp
     server_timestamp = std::time(nullptr);
@@ -643,6 +696,8 @@ index2(uint64_t page_no = 0, bool refresh_page = false)
             {"enable_autorefresh_option", enable_autorefresh_option}
     };
 
+    add_live_updates(context);
+
     context.emplace("txs", mstch::array()); // will keep tx to show
 
     // get reference to txs mstch map to be field below
@@ -693,20 +748,21 @@ index2(uint64_t page_no = 0, bool refresh_page = false)
 
         context["age_format"] = age.second;
 
-        // start measure time here
-        auto start = std::chrono::steady_clock::now();
-
         // get all transactions in the block found
         // initialize the first list with transaction for solving
         // the block i.e. coinbase.
         vector<cryptonote::transaction> blk_txs {blk.miner_tx};
         vector<crypto::hash> missed_txs;
 
-        if (!core_storage->get_transactions(blk.tx_hashes, blk_txs, missed_txs))
         {
-            cerr << "Cant get transactions in block: " << i << endl;
-            --i;
-            continue;
+            RequestTimings::phase timer {RequestTimings::db};
+
+            if (!core_storage->get_transactions(blk.tx_hashes, blk_txs, missed_txs))
+            {
+                cerr << "Cant get transactions in block: " << i << endl;
+                --i;
+                continue;
+            }
         }
 
         uint64_t tx_i {0};
@@ -754,9 +810,6 @@ index2(uint64_t page_no = 0, bool refresh_page = false)
             txs.push_back(boost::get<mstch::map>(txd_pair.second));
         }
 
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>
-                (std::chrono::steady_clock::now() - start);
-
         --i; // go to next block number
 
     } // while (i <= end_height)
@@ -816,18 +869,25 @@ index2(uint64_t page_no = 0, bool refresh_page = false)
 
     string mempool_html {"Cant get mempool_pool"};
 
-    // get mempool data for the front page, if ready. If not, then just skip.
-    std::future_status mempool_ftr_status = mempool_ftr.wait_for(
-            std::chrono::milliseconds(mempool_info_timeout));
-
-    if (mempool_ftr_status == std::future_status::ready)
+    if (mempool_html_rendered)
     {
-        mempool_html = mempool_ftr.get();
+        mempool_html = *mempool_html_rendered;
     }
     else
     {
-        cerr  << "mempool future not ready yet, skipping." << endl;
-        mempool_html = mstch::render(template_file["mempool_error"], context);
+        // get mempool data for the front page, if ready. If not, then just skip.
+        std::future_status mempool_ftr_status = mempool_ftr.wait_for(
+                std::chrono::milliseconds(mempool_info_timeout));
+
+        if (mempool_ftr_status == std::future_status::ready)
+        {
+            mempool_html = mempool_ftr.get();
+        }
+        else
+        {
+            cerr  << "mempool future not ready yet, skipping." << endl;
+            mempool_html = mstch::render(template_file["mempool_error"], context);
+        }
     }
 
     if (CurrentBlockchainStatus::is_thread_running())
@@ -860,40 +920,124 @@ index2(uint64_t page_no = 0, bool refresh_page = false)
     add_css_style(context);
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["index2"], context);
 }
 
 /**
  * Render mempool data
+ *
+ * The rendered page is memoized in the current mempool
+ * snapshot, so it is rendered only once per mempool refresh.
  */
 string
 mempool(bool add_header_and_footer = false, uint64_t no_of_mempool_tx = 25)
 {
-    // Use shared_ptr to avoid deep copy of mempool transactions
-    auto mempool_txs = add_header_and_footer
-        ? MempoolStatus::get_mempool_txs()
-        : MempoolStatus::get_mempool_txs(no_of_mempool_tx);
+    auto snapshot = MempoolStatus::get_mempool_snapshot();
+
+    string render_key = mempool_render_key(add_header_and_footer,
+                                           no_of_mempool_tx);
+
+    bool is_hit {false};
+
+    // there are only two of them, front page and full mempool page
+    auto rendered = snapshot->get_or_render(render_key, true, [&]()
+    {
+        return render_mempool(snapshot, add_header_and_footer, no_of_mempool_tx);
+    }, is_hit);
+
+    Metrics::add_cache_access("mempool_html", is_hit);
+
+    return *rendered;
+}
+
+/*
+ * Lets use this json api convention for success and error
+ * https://labs.omniti.com/labs/jsend
+ *
+ * The same as json_mempool, but already serialized and memoized
+ * in the current mempool snapshot, so that /api/mempool
+ * requests between two mempool refreshes get the same bytes.
+ */
+string
+json_mempool_serialized(string _page, string _limit)
+{
+    auto snapshot = MempoolStatus::get_mempool_snapshot();
+
+    uint64_t page {0};
+    uint64_t limit {0};
+
+    try
+    {
+        page  = boost::lexical_cast<uint64_t>(_page);
+        limit = boost::lexical_cast<uint64_t>(_limit);
+    }
+    catch (const boost::bad_lexical_cast& e)
+    {
+        // json_mempool responds with the error
+        return json_mempool(_page, _limit, snapshot).dump();
+    }
+
+    // pages and limits which show the same txs get the same
+    // key, e.g., limits over the mempool size, or pages after
+    // the last one, so that they dont fill the memo. All pages
+    // after the one following the last show the last limit txs
+    // in json_mempool, so they are all shown as the first of them.
+    uint64_t no_mempool_txs = snapshot->size();
 
-    if (!mempool_txs)
-        mempool_txs = std::make_shared<std::vector<MempoolStatus::mempool_tx>>();
+    limit = std::min(limit, no_mempool_txs);
+
+    page = limit > 0
+           ? std::min(page, (no_mempool_txs + limit - 1) / limit + 1)
+           : 0;
+
+    // whole mempool, e.g., default /api/mempool
+    bool is_pinned = (page == 0 && limit == no_mempool_txs);
+
+    string render_key = fmt::format("json_{:d}_{:d}", page, limit);
+
+    bool is_hit {false};
+
+    auto rendered = snapshot->get_or_render(render_key, is_pinned, [&]()
+    {
+        json j_response = json_mempool(std::to_string(page),
+                                       std::to_string(limit),
+                                       snapshot);
+
+        RequestTimings::phase timer {RequestTimings::serialize};
+
+        return j_response.dump();
+    }, is_hit);
+
+    Metrics::add_cache_access("mempool_json", is_hit);
+
+    return *rendered;
+}
+
+string
+render_mempool(MempoolStatus::mempool_snapshot_ptr const& snapshot,
+               bool add_header_and_footer, uint64_t no_of_mempool_tx)
+{
+    MempoolStatus::mempool_snapshot const& mempool_txs = *snapshot;
 
     if (add_header_and_footer)
     {
-        no_of_mempool_tx = mempool_txs->size();
+        no_of_mempool_tx = mempool_txs.size();
     }
     else
     {
-        no_of_mempool_tx = std::min<uint64_t>(no_of_mempool_tx, mempool_txs->size());
+        no_of_mempool_tx = std::min<uint64_t>(no_of_mempool_tx, mempool_txs.size());
     }
 
     // total size of mempool in bytes
-    uint64_t mempool_size_bytes = MempoolStatus::mempool_size;
+    uint64_t mempool_size_bytes = mempool_txs.size_bytes;
 
     // reasign this number, in case no of txs in mempool is smaller
     // than what we requested or we want all txs.
 
 
-    uint64_t total_no_of_mempool_tx = MempoolStatus::mempool_no;
+    uint64_t total_no_of_mempool_tx = mempool_txs.size();
 
     // initalise page tempate map with basic info about mempool
     mstch::map context {
@@ -906,18 +1050,20 @@ mempool(bool add_header_and_footer = false, uint64_t no_of_mempool_tx = 25)
     // get reference to blocks template map to be field below
     mstch::array& txs = boost::get<mstch::array>(context["mempooltxs"]);
 
-    uint64_t local_copy_server_timestamp = server_timestamp;
+    // rendered page is memoized, so its ages are
+    // as of now, not as of the last request
+    uint64_t local_copy_server_timestamp = std::time(nullptr);
 
     // for each transaction in the memory pool
     for (size_t i = 0; i < no_of_mempool_tx; ++i)
     {
-        // get transaction info of the tx in the mempool
-        const MempoolStatus::mempool_tx& mempool_tx = mempool_txs->at(i);
+        uint64_t receive_time = mempool_txs.receive_times[i];
+        uint64_t fee          = mempool_txs.fees[i];
 
         // calculate difference between tx in mempool and server timestamps
         array<size_t, 5> delta_time = timestamp_difference(
                 local_copy_server_timestamp,
-                mempool_tx.receive_time);
+                receive_time);
 
         // use only hours, so if we have days, add
         // it to hours
@@ -937,21 +1083,25 @@ mempool(bool add_header_and_footer = false, uint64_t no_of_mempool_tx = 25)
         }
 
 
+        double tx_size = static_cast<double>(mempool_txs.blob_sizes[i])/1024.0;
+
+        double payed_for_kB = XMR_AMOUNT(fee) / tx_size;
+
         // set output page template map
         txs.push_back(mstch::map {
-                {"timestamp_no"    , mempool_tx.receive_time},
-                {"timestamp"       , mempool_tx.timestamp_str},
+                {"timestamp_no"    , receive_time},
+                {"timestamp"       , xmreg::timestamp_to_str_gm(receive_time)},
                 {"age"             , age_str},
-                {"hash"            , pod_to_hex(mempool_tx.tx_hash)},
-                {"fee"             , mempool_tx.fee_micro_str},
-                {"payed_for_kB"    , mempool_tx.payed_for_kB_micro_str},
-                {"xmr_inputs"      , mempool_tx.xmr_inputs_str},
-                {"xmr_outputs"     , mempool_tx.xmr_outputs_str},
-                {"no_inputs"       , mempool_tx.no_inputs},
-                {"no_outputs"      , mempool_tx.no_outputs},
-                {"no_nonrct_inputs", mempool_tx.num_nonrct_inputs},
-                {"mixin"           , mempool_tx.mixin_no},
-                {"txsize"          , mempool_tx.txsize}
+                {"hash"            , pod_to_hex(mempool_txs.tx_hashes[i])},
+                {"fee"             , xmreg::xmr_amount_to_str(fee*1.0e6, "{:04.0f}", false)},
+                {"payed_for_kB"    , fmt::format("{:04.0f}", payed_for_kB*1e6)},
+                {"xmr_inputs"      , xmreg::xmr_amount_to_str(mempool_txs.sum_inputs[i], "{:0.3f}")},
+                {"xmr_outputs"     , xmreg::xmr_amount_to_str(mempool_txs.sum_outputs[i], "{:0.3f}")},
+                {"no_inputs"       , mempool_txs.no_inputs[i]},
+                {"no_outputs"      , mempool_txs.no_outputs[i]},
+                {"no_nonrct_inputs", mempool_txs.num_nonrct_inputs[i]},
+                {"mixin"           , mempool_txs.mixin_nos[i]},
+                {"txsize"          , fmt::format("{:0.2f}", tx_size)}
         });
     }
 
@@ -964,20 +1114,26 @@ mempool(bool add_header_and_footer = false, uint64_t no_of_mempool_tx = 25)
         // this is when mempool is on its own page, /mempool
         add_css_style(context);
 
+        add_mempool_stats(context, *snapshot, local_copy_server_timestamp);
+
         context["partial_mempool_shown"] = false;
 
         // render the page
+        RequestTimings::phase timer {RequestTimings::render};
+
         return mstch::render(template_file["mempool_full"], context);
     }
 
     // this is for partial disply on front page.
 
-    context["mempool_fits_on_front_page"]    = (total_no_of_mempool_tx <= mempool_txs->size());
+    context["mempool_fits_on_front_page"]    = (total_no_of_mempool_tx <= no_of_mempool_tx);
     context["no_of_mempool_tx_of_frontpage"] = no_of_mempool_tx;
 
     context["partial_mempool_shown"] = true;
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["mempool"], context);
 }
 
@@ -998,41 +1154,23 @@ altblocks()
     // get reference to alt blocks template map to be field below
     mstch::array& blocks = boost::get<mstch::array>(context["blocks"]);
 
-    vector<string> atl_blks_hashes;
+    vector<alt_block_info> alt_blocks = get_alt_blocks();
 
-    if (!rpc.get_alt_blocks(atl_blks_hashes))
-    {
-        cerr << "rpc.get_alt_blocks(atl_blks_hashes) failed" << endl;
-    }
-
-    context.emplace("no_alt_blocks", (uint64_t)atl_blks_hashes.size());
+    context.emplace("no_alt_blocks", (uint64_t)alt_blocks.size());
 
-    for (const string& alt_blk_hash: atl_blks_hashes)
+    for (const alt_block_info& alt_blk: alt_blocks)
     {
-        block alt_blk;
-        string error_msg;
-
-        int64_t no_of_txs {-1};
-        int64_t blk_height {-1};
-
         // get block age
         pair<string, string> age {"-1", "-1"};
 
-
-        if (rpc.get_block(alt_blk_hash, alt_blk, error_msg))
-        {
-            no_of_txs  = alt_blk.tx_hashes.size();
-
-            blk_height = get_block_height(alt_blk);
-
+        if (alt_blk.timestamp > 0)
             age = get_age(local_copy_server_timestamp, alt_blk.timestamp);
-        }
 
         blocks.push_back(mstch::map {
-                {"height"   , blk_height},
+                {"height"   , alt_blk.height},
                 {"age"      , age.first},
-                {"hash"     , alt_blk_hash},
-                {"no_of_txs", no_of_txs}
+                {"hash"     , alt_blk.hash},
+                {"no_of_txs", alt_blk.no_of_txs}
         });
 
     }
@@ -1040,9 +1178,165 @@ altblocks()
     add_css_style(context);
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["altblocks"], context);
 }
 
+/**
+ * Alt blocks, newest first. They are read from the alt blocks
+ * table of the lmdb. If that fails, they are fetched from the
+ * daemon. Results are cached until the chain tip or the number
+ * of alt blocks changes, so the daemon is not called for
+ * each page view.
+ */
+vector<alt_block_info>
+get_alt_blocks()
+{
+    // concurrent requests wait for the first one to
+    // refresh the cache, instead of all of them doing it
+    std::lock_guard<mutex> lck (alt_blocks_mutx);
+
+    crypto::hash tip_hash {crypto::null_hash};
+    uint64_t no_of_alt_blocks {0};
+
+    try
+    {
+        tip_hash         = core_storage->get_db().top_block_hash();
+        no_of_alt_blocks = core_storage->get_db().get_alt_block_count();
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant get top block hash or no of alt blocks: "
+             << e.what() << endl;
+    }
+
+    bool is_cached = alt_blocks_cached
+                     && tip_hash == alt_blocks_tip
+                     && no_of_alt_blocks == alt_blocks_count;
+
+    Metrics::add_cache_access("alt_blocks", is_cached);
+
+    if (is_cached)
+        return alt_blocks_cache;
+
+    vector<alt_block_info> alt_blocks;
+
+    if (!get_alt_blocks_from_lmdb(alt_blocks))
+    {
+        alt_blocks.clear();
+
+        if (!get_alt_blocks_from_rpc(alt_blocks))
+        {
+            // not cached, so we try again with next request
+            return alt_blocks;
+        }
+    }
+
+    std::sort(alt_blocks.begin(), alt_blocks.end(),
+              [](alt_block_info const& b1, alt_block_info const& b2)
+              {
+                  return b1.height > b2.height;
+              });
+
+    alt_blocks_cache  = alt_blocks;
+    alt_blocks_tip    = tip_hash;
+    alt_blocks_count  = no_of_alt_blocks;
+    alt_blocks_cached = true;
+
+    return alt_blocks;
+}
+
+bool
+get_alt_blocks_from_lmdb(vector<alt_block_info>& alt_blocks)
+{
+    try
+    {
+        core_storage->get_db().for_all_alt_blocks(
+                [&](crypto::hash const& blk_hash,
+                    cryptonote::alt_block_data_t const& data,
+                    cryptonote::blobdata_ref const* blob) -> bool
+        {
+            alt_block_info alt_blk_info;
+
+            alt_blk_info.hash   = pod_to_hex(blk_hash);
+            alt_blk_info.height = data.height;
+
+            block alt_blk;
+
+            if (blob && parse_and_validate_block_from_blob(
+                    cryptonote::blobdata {blob->data(), blob->size()},
+                    alt_blk))
+            {
+                alt_blk_info.timestamp = alt_blk.timestamp;
+                alt_blk_info.no_of_txs = alt_blk.tx_hashes.size();
+            }
+
+            alt_blocks.push_back(alt_blk_info);
+
+            return true;
+        }, true);
+    }
+    catch (std::exception const& e)
+    {
+        cerr << "Cant read alt blocks from lmdb: " << e.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool
+get_alt_blocks_from_rpc(vector<alt_block_info>& alt_blocks)
+{
+    vector<string> atl_blks_hashes;
+
+    if (!rpc.get_alt_blocks(atl_blks_hashes))
+    {
+        cerr << "rpc.get_alt_blocks(atl_blks_hashes) failed" << endl;
+        return false;
+    }
+
+    alt_blocks.resize(atl_blks_hashes.size());
+
+    // blocks are fetched in parallel, using as many
+    // threads as there are connections to the daemon
+    atomic<size_t> next_blk {0};
+
+    auto fetch_blocks = [&]()
+    {
+        for (size_t i = next_blk++; i < atl_blks_hashes.size(); i = next_blk++)
+        {
+            alt_block_info& alt_blk_info = alt_blocks[i];
+
+            alt_blk_info.hash = atl_blks_hashes[i];
+
+            block alt_blk;
+            string error_msg;
+
+            if (rpc.get_block(alt_blk_info.hash, alt_blk, error_msg))
+            {
+                alt_blk_info.height    = get_block_height(alt_blk);
+                alt_blk_info.timestamp = alt_blk.timestamp;
+                alt_blk_info.no_of_txs = alt_blk.tx_hashes.size();
+            }
+        }
+    };
+
+    size_t no_of_threads = std::min<size_t>(
+            atl_blks_hashes.size(), rpccalls::default_max_connections);
+
+    vector<std::future<void>> fetches;
+
+    for (size_t i = 0; i < no_of_threads; ++i)
+        fetches.push_back(std::async(std::launch::async, fetch_blocks));
+
+    for (auto& fetch: fetches)
+        fetch.get();
+
+    return true;
+}
+
 
 string
 show_block(uint64_t _blk_height)
@@ -1224,6 +1518,8 @@ show_block(uint64_t _blk_height)
     add_css_style(context);
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["block"], context);
 }
 
@@ -1353,7 +1649,7 @@ show_tx(string tx_hash_str, uint16_t with_ring_signatures = 0, bool refresh_page
         if (!found_txs.empty())
         {
             // there should be only one tx found
-            tx = found_txs.at(0).tx;
+            tx = *found_txs.at(0).get_tx();
 
             // since its tx in mempool, it has no blk yet
             // so use its recive_time as timestamp to show
@@ -1397,6 +1693,8 @@ show_tx(string tx_hash_str, uint16_t with_ring_signatures = 0, bool refresh_page
             {"tx_hash"          , tx_hash_str}
     };
 
+    add_live_updates(context);
+
     boost::get<mstch::array>(context["txs"]).push_back(tx_context);
 
     map<string, string> partials {
@@ -1406,6 +1704,8 @@ show_tx(string tx_hash_str, uint16_t with_ring_signatures = 0, bool refresh_page
     add_css_style(context);
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["tx"], context, partials);
 }
 
@@ -2020,6 +2320,8 @@ show_my_outputs(string tx_hash_str,
         crypto::hash tx_hash_from_blob;
         crypto::hash tx_prefix_hash_from_blob;
 
+        RequestTimings::phase parsing {RequestTimings::decode};
+
         if (!cryptonote::parse_and_validate_tx_from_blob(tx_data_blob,
                                                          tx,
                                                          tx_hash_from_blob,
@@ -2045,7 +2347,7 @@ show_my_outputs(string tx_hash_str,
         if (!found_txs.empty())
         {
             // there should be only one tx found
-            tx = found_txs.at(0).tx;
+            tx = *found_txs.at(0).get_tx();
 
             // since its tx in mempool, it has no blk yet
             // so use its recive_time as timestamp to show
@@ -2147,7 +2449,7 @@ show_my_outputs(string tx_hash_str,
 
     string server_time_str = xmreg::timestamp_to_str_gm(server_timestamp, "%F");
 
-
+    RequestTimings::phase decoding {RequestTimings::decode};
 
     // public transaction key is combined with our viewkey
     // to create, so called, derived key.
@@ -2316,6 +2618,8 @@ show_my_outputs(string tx_hash_str,
     context["found_our_outputs"] = (sum_xmr > 0);
     context["sum_xmr"]           = xmreg::xmr_amount_to_str(sum_xmr);
 
+    decoding.stop();
+
     // we can also test ouputs used in mixins for key images
     // this can show possible spending. Only possible, because
     // without a spend key, we cant know for sure. It might be
@@ -2344,8 +2648,19 @@ show_my_outputs(string tx_hash_str,
         //                     public_key    , amount
         std::vector<std::pair<crypto::public_key, uint64_t>> all_possible_mixins;
 
+        // if request takes too long, we show only inputs checked so far
+        bool inputs_partial {false};
+
+        RequestTimings::phase resolving_rings {RequestTimings::rings};
+
         for (const txin_to_key& in_key: input_key_imgs)
         {
+            if (RequestDeadline::expired())
+            {
+                inputs_partial = true;
+                break;
+            }
+
             // get absolute offsets of mixins
             std::vector<uint64_t> absolute_offsets
                     = cryptonote::relative_output_offsets_to_absolute(
@@ -2711,6 +3026,7 @@ show_my_outputs(string tx_hash_str,
         context.emplace("inputs", inputs);
 
         context["show_inputs"]   = show_key_images;
+        context["inputs_partial"] = inputs_partial;
         context["inputs_no"]     = static_cast<uint64_t>(inputs.size());
         context["sum_mixin_xmr"] = xmreg::xmr_amount_to_str(
                 sum_mixin_xmr, "{:0.12f}", false);
@@ -2738,7 +3054,8 @@ show_my_outputs(string tx_hash_str,
         // show spending only if sum of mixins is more than
         // what we get + fee, and number of perferctly matched
         // mixis is equal to number of inputs
-        if (sum_mixin_xmr > (sum_xmr + txd.fee)
+        if (!inputs_partial
+            && sum_mixin_xmr > (sum_xmr + txd.fee)
             && no_of_matched_mixins == inputs.size())
         {
             //                  (outcoming    - incoming) - fee
@@ -2753,6 +3070,8 @@ show_my_outputs(string tx_hash_str,
     add_css_style(context);
 
     // render the page
+    RequestTimings::phase timer {RequestTimings::render};
+
     return mstch::render(template_file["my_outputs"], context);
 }
 
@@ -3353,6 +3672,9 @@ show_checkrawtx(string raw_tx_data, string action)
             // get reference to inputs array created of the tx
             mstch::array& inputs = boost::get<mstch::array>(tx_context["inputs"]);
 
+            // to check if key images are spent by txs in the mempool
+            auto mempool_snapshot = MempoolStatus::get_mempool_snapshot();
+
             uint64_t input_idx {0};
 
             // mark which mixin is real in each input's mstch context
@@ -3379,6 +3701,17 @@ show_checkrawtx(string raw_tx_data, string action)
                 if (epee::string_tools::hex_to_pod(in_key_img_str, key_imgage))
                 {
                     input_map["already_spent"] = core_storage->get_db().has_key_image(key_imgage);
+
+                    // key image can be also spent by a tx
+                    // which is still in the mempool
+                    MempoolStatus::mempool_tx mempool_tx;
+
+                    if (mempool_snapshot->find_tx_by_key_image(key_imgage, mempool_tx))
+                    {
+                        input_map["already_spent"]       = true;
+                        input_map["spent_in_mempool"]    = true;
+                        input_map["spent_in_mempool_tx"] = pod_to_hex(mempool_tx.tx_hash);
+                    }
                 }
 
                 // mark real mixings
@@ -3567,12 +3900,18 @@ show_pushrawtx(string raw_tx_data, string action)
             break;
         }
 
-        // check if any key images of the tx to be submited are already spend
+        // check if any key images of the tx to be submited are already spend,
+        // either in the blockchain or by txs in the mempool
         vector<key_image> key_images_spent;
 
+        auto mempool_snapshot = MempoolStatus::get_mempool_snapshot();
+
+        MempoolStatus::mempool_tx mempool_tx;
+
         for (const txin_to_key& tx_in: txd.input_key_imgs)
         {
-            if (core_storage->have_tx_keyimg_as_spent(tx_in.k_image))
+            if (core_storage->have_tx_keyimg_as_spent(tx_in.k_image)
+                    || mempool_snapshot->find_tx_by_key_image(tx_in.k_image, mempool_tx))
                 key_images_spent.push_back(tx_in.k_image);
         }
 
@@ -3780,6 +4119,16 @@ show_checkrawkeyimgs(string raw_data, string viewkey_str)
 
     for (size_t n = 0; n < no_key_images; ++n)
     {
+        if (RequestDeadline::expired())
+        {
+            context["has_error"] = true;
+            context["error_msg"] = fmt::format(
+                    "Request took too long. Checked {:d} of {:d} key images.",
+                    n, no_key_images);
+
+            return mstch::render(full_page, context);
+        }
+
         const char* record_ptr = decoded_raw_data.data() + header_lenght + n * record_lenght;
 
         crypto::key_image key_image
@@ -3938,6 +4287,15 @@ show_checkcheckrawoutput(string raw_data, string viewkey_str)
 
     for (const tools::wallet2::transfer_details& td: outputs)
     {
+        if (RequestDeadline::expired())
+        {
+            context["has_error"] = true;
+            context["error_msg"] = fmt::format(
+                    "Request took too long. Checked {:d} of {:d} outputs.",
+                    output_no, outputs.size());
+
+            return mstch::render(full_page, context);
+        }
 
         const transaction_prefix& txp = td.m_tx;
 
@@ -4356,7 +4714,7 @@ show_search_results(const string& search_text,
                     if (!found_txs.empty())
                     {
                         // there should be only one tx found
-                        tx = found_txs.at(0).tx;
+                        tx = *found_txs.at(0).get_tx();
                     }
                     else
                     {
@@ -4726,6 +5084,15 @@ json_detailedtransaction(string tx_hash_str)
     // get detailed tx information
     mstch::map tx_context = construct_tx_context(tx, 1 /*full detailed */);
 
+    // e.g., ring members could not be read or the request
+    // took too long, so inputs would be incomplete
+    if (boost::get<bool>(tx_context["has_error"]))
+    {
+        j_response["status"]  = "error";
+        j_response["message"] = boost::get<string>(tx_context["error_msg"]);
+        return j_response;
+    }
+
     // remove some page specific and html stuff
     tx_context.erase("timescales");
     tx_context.erase("tx_json");
@@ -5118,7 +5485,8 @@ json_transactions(string _page, string _limit)
 * https://labs.omniti.com/labs/jsend
 */
 json
-json_mempool(string _page, string _limit)
+json_mempool(string _page, string _limit,
+             MempoolStatus::mempool_snapshot_ptr mempool_data = nullptr)
 {
     json j_response {
             {"status", "fail"},
@@ -5149,10 +5517,9 @@ json_mempool(string _page, string _limit)
 
     uint64_t local_copy_server_timestamp = server_timestamp;
 
-    uint64_t height = core_storage->get_current_blockchain_height();
-
     // get mempool tx from mempoolstatus thread (shared_ptr avoids deep copy)
-    auto mempool_data = MempoolStatus::get_mempool_txs();
+    if (!mempool_data)
+        mempool_data = MempoolStatus::get_mempool_snapshot();
 
     uint64_t no_mempool_txs = mempool_data ? mempool_data->size() : 0;
 
@@ -5173,31 +5540,41 @@ json_mempool(string _page, string _limit)
 
     json j_txs = json::array();
 
-    // for each transaction in the memory pool in current page
+    // for each transaction in the memory pool in current page.
+    // All is taken from the snapshot's columns, as the same
+    // get_tx_json would take from full txs, so that full txs
+    // dropped to save memory are not parsed again here.
     while (i < end_height)
     {
-        const MempoolStatus::mempool_tx* mempool_tx {nullptr};
-
-        try
-        {
-            mempool_tx = &(mempool_data->at(i));
-        }
-        catch (const std::out_of_range& e)
-        {
-            j_response["status"]  = "error";
-            j_response["message"] = fmt::format("Getting mempool txs failed due to std::out_of_range");
-
-            return j_response;
-        }
-
-        const tx_details& txd = get_tx_details(mempool_tx->tx, false, 1, height); // 1 is dummy here
+        crypto::hash payment_id  = null_hash;
+        crypto::hash8 payment_id8 = null_hash8;
+
+        vector<uint8_t> const& extra = mempool_data->full_txs[i]->get_extra();
+
+        get_payment_id(extra, payment_id, payment_id8);
+
+        json j_tx {
+                {"tx_hash"     , pod_to_hex(mempool_data->tx_hashes[i])},
+                {"tx_fee"      , mempool_data->fees[i]},
+                {"mixin"       , mempool_data->mixin_nos[i]},
+                {"tx_size"     , mempool_data->blob_sizes[i]},
+                {"xmr_outputs" , mempool_data->sum_outputs[i]},
+                {"xmr_inputs"  , mempool_data->sum_inputs[i]},
+                {"tx_version"  , static_cast<uint64_t>(mempool_data->versions[i])},
+                {"rct_type"    , mempool_data->rct_types[i]},
+                {"coinbase"    , false},
+                {"extra"       , epee::string_tools::buff_to_hex_nodelimer(
+                        string {reinterpret_cast<const char*>(extra.data()),
+                                extra.size()})},
+                {"payment_id"  , (payment_id  != null_hash  ? pod_to_hex(payment_id)  : "")},
+                {"payment_id8" , (payment_id8 != null_hash8 ? pod_to_hex(payment_id8) : "")},
+        };
 
-        // get basic tx info
-        json j_tx = get_tx_json(mempool_tx->tx, txd);
+        uint64_t receive_time = mempool_data->receive_times[i];
 
         // we add some extra data, for mempool txs, such as recieve timestamp
-        j_tx["timestamp"]     = mempool_tx->receive_time;
-        j_tx["timestamp_utc"] = mempool_tx->timestamp_str;
+        j_tx["timestamp"]     = receive_time;
+        j_tx["timestamp_utc"] = xmreg::timestamp_to_str_gm(receive_time);
 
         j_txs.push_back(j_tx);
 
@@ -5216,6 +5593,72 @@ json_mempool(string _page, string _limit)
 }
 
 
+/*
+ * Lets use this json api convention for success and error
+ * https://labs.omniti.com/labs/jsend
+ */
+json
+json_mempoolstats()
+{
+    json j_response {
+            {"status", "fail"},
+            {"data",   json {}}
+    };
+
+    json& j_data = j_response["data"];
+
+    // stats are kept up to date by mempoolstatus thread,
+    // so nothing to calculate here.
+    auto snapshot = MempoolStatus::get_mempool_snapshot();
+
+    MempoolStatus::mempool_stats const& stats = snapshot->stats;
+
+    json j_histogram = json::array();
+
+    auto const& buckets = MempoolStatus::mempool_stats::fee_per_byte_buckets;
+
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        auto const& bucket = stats.fee_histogram[i];
+
+        j_histogram.push_back(json {
+                {"fee_per_byte_min", buckets[i]},
+                {"fee_per_byte_max", i + 1 < buckets.size()
+                                     ? json(buckets[i + 1]) : json(nullptr)},
+                {"txs_no"          , bucket.txs_no},
+                {"size"            , bucket.size},
+                {"weight"          , bucket.weight},
+                {"fee"             , bucket.fee}
+        });
+    }
+
+    uint64_t current_timestamp = std::time(nullptr);
+
+    json j_ages;
+
+    for (auto const& percentile: mempool_age_percentiles)
+    {
+        uint64_t receive_time = snapshot->receive_time_percentile(percentile.second);
+
+        j_ages[percentile.first] = snapshot->empty()
+                                   ? 0 : current_timestamp - std::min(receive_time, current_timestamp);
+    }
+
+    j_data["txs_no"]          = stats.txs_no;
+    j_data["total_size"]      = stats.total_size;
+    j_data["total_weight"]    = stats.total_weight;
+    j_data["total_fee"]       = stats.total_fee;
+    j_data["fee_histogram"]   = j_histogram;
+    j_data["age_percentiles"] = j_ages;
+    j_data["timestamp"]       = snapshot->timestamp;
+    j_data["version"]         = snapshot->version;
+
+    j_response["status"] = "success";
+
+    return j_response;
+}
+
+
 /*
  * Lets use this json api convention for success and error
  * https://labs.omniti.com/labs/jsend
@@ -5387,6 +5830,8 @@ json_outputs(string tx_hash_str,
 
     tx_details txd = get_tx_details(tx);
 
+    RequestTimings::phase decoding {RequestTimings::decode};
+
     // public transaction key is combined with our viewkey
     // to create, so called, derived key.
     key_derivation derivation;
@@ -5628,9 +6073,9 @@ json_outputsblocks(string startblock,
     {
         // first check if there is something for us in the mempool
         // get mempool tx from mempoolstatus thread (shared_ptr avoids deep copy)
-        auto mempool_txs = MempoolStatus::get_mempool_txs();
+        auto mempool_txs = MempoolStatus::get_mempool_snapshot();
 
-        uint64_t no_mempool_txs = mempool_txs ? mempool_txs->size() : 0;
+        uint64_t no_mempool_txs = mempool_txs->size();
 
         // need to use vector<transactions>,
         // not vector<MempoolStatus::mempool_tx>
@@ -5639,9 +6084,10 @@ json_outputsblocks(string startblock,
 
         for (size_t i = 0; i < no_mempool_txs; ++i)
         {
-            // get transaction info of the tx in the mempool
+            // get transaction of the tx in the mempool.
             // Note: we copy the tx here since the shared_ptr data is read-only
-            tmp_vector.push_back(mempool_txs->at(i).tx);
+            if (auto mempool_tx = mempool_txs->full_txs[i]->get())
+                tmp_vector.push_back(*mempool_tx);
         }
 
         if (!find_our_outputs(
@@ -5815,6 +6261,176 @@ json_emission()
 }
 
 
+/*
+ * Lets use this json api convention for success and error
+ * https://labs.omniti.com/labs/jsend
+ *
+ * Emission of blocks from _start to _end height, inclusive.
+ * With _start of 0, this is supply at _end height.
+ */
+json
+json_emission_range(string _start, string _end)
+{
+    json j_response {
+            {"status", "fail"},
+            {"data",   json {}}
+    };
+
+    json& j_data = j_response["data"];
+
+    if (!CurrentBlockchainStatus::is_thread_running())
+    {
+        j_data["title"] = "Emission monitoring thread not enabled.";
+        return j_response;
+    }
+
+    if (_start.empty() || _end.empty())
+    {
+        j_data["title"] = "Either height, or both start and end "
+                          "heights are needed.";
+        return j_response;
+    }
+
+    uint64_t start_height {0};
+    uint64_t end_height {0};
+
+    try
+    {
+        start_height = boost::lexical_cast<uint64_t>(_start);
+        end_height   = boost::lexical_cast<uint64_t>(_end);
+    }
+    catch (const boost::bad_lexical_cast& e)
+    {
+        j_data["title"] = fmt::format(
+                "Cant parse start and/or end heights: {:s}, {:s}", _start, _end);
+        return j_response;
+    }
+
+    CurrentBlockchainStatus::Emission emission;
+
+    if (!CurrentBlockchainStatus::get_emission_between(
+            start_height, end_height, emission))
+    {
+        j_data["title"] = fmt::format(
+                "Emission for blocks {:d} - {:d} is not available. "
+                "Emission is calculated up to block {:d}.",
+                start_height, end_height,
+                static_cast<int64_t>(CurrentBlockchainStatus::get_emission().blk_no) - 1);
+        return j_response;
+    }
+
+    j_data = json {
+            {"start_height", start_height},
+            {"end_height"  , end_height},
+            {"coinbase"    , emission.coinbase},
+            {"fee"         , emission.fee},
+    };
+
+    j_response["status"]  = "success";
+
+    return j_response;
+}
+
+
+/*
+ * Lets use this json api convention for success and error
+ * https://labs.omniti.com/labs/jsend
+ *
+ * Whole daily or weekly series of chain stats. Series are
+ * given column-wise, i.e., i-th values of all arrays are
+ * of the i-th day or week. The response is serialized only once
+ * for each update of the stats.
+ */
+string
+json_chainstats_serialized(string period)
+{
+    json j_response {
+            {"status", "fail"},
+            {"data",   json {}}
+    };
+
+    json& j_data = j_response["data"];
+
+    if (!ChainStats::is_thread_running())
+    {
+        j_data["title"] = "Chain stats thread not enabled.";
+        return j_response.dump();
+    }
+
+    if (period != "day" && period != "week")
+    {
+        j_data["title"] = "Period must be day or week.";
+        return j_response.dump();
+    }
+
+    auto snapshot = ChainStats::get_stats_snapshot();
+
+    auto rendered = snapshot->get_render(period);
+
+    Metrics::add_cache_access("chain_stats", rendered != nullptr);
+
+    if (rendered)
+        return *rendered;
+
+    ChainStats::series const& buckets = period == "day"
+                                        ? snapshot->data.days
+                                        : snapshot->data.weeks;
+
+    static const array<string, ChainStats::no_of_rct_types> rct_type_names {
+            "none", "full", "simple", "bulletproof",
+            "bulletproof2", "clsag", "bulletproof_plus"};
+
+    json j_timestamps = json::array();
+    json j_blocks     = json::array();
+    json j_txs        = json::array();
+    json j_fees       = json::array();
+    json j_weights    = json::array();
+    json j_inputs     = json::array();
+    json j_outputs    = json::array();
+
+    array<json, ChainStats::no_of_rct_types> j_rct_types;
+    j_rct_types.fill(json::array());
+
+    for (auto const& ts_bucket: buckets)
+    {
+        ChainStats::bucket const& b = ts_bucket.second;
+
+        j_timestamps.push_back(ts_bucket.first);
+        j_blocks.push_back(b.no_blocks);
+        j_txs.push_back(b.no_txs);
+        j_fees.push_back(b.fee);
+        j_weights.push_back(b.weight);
+        j_inputs.push_back(b.no_inputs);
+        j_outputs.push_back(b.no_outputs);
+
+        for (size_t i = 0; i < ChainStats::no_of_rct_types; ++i)
+            j_rct_types[i].push_back(b.rct_types[i]);
+    }
+
+    j_data = json {
+            {"period"       , period},
+            {"height"       , snapshot->data.height},
+            {"timestamps"   , j_timestamps},
+            {"blocks"       , j_blocks},
+            {"txs"          , j_txs},
+            {"fees"         , j_fees},
+            {"block_weights", j_weights},
+            {"inputs"       , j_inputs},
+            {"outputs"      , j_outputs},
+            {"rct_types"    , json::object()}
+    };
+
+    for (size_t i = 0; i < ChainStats::no_of_rct_types; ++i)
+        j_data["rct_types"][rct_type_names[i]] = j_rct_types[i];
+
+    j_response["status"]  = "success";
+
+    RequestTimings::phase timer {RequestTimings::serialize};
+
+    return *snapshot->add_render(period, j_response.dump());
+}
+
+
 /*
       * Lets use this json api convention for success and error
       * https://labs.omniti.com/labs/jsend
@@ -5846,6 +6462,66 @@ json_version()
 
 private:
 
+void
+add_mempool_stats(mstch::map& context,
+                  MempoolStatus::mempool_snapshot const& snapshot,
+                  uint64_t current_timestamp)
+{
+    MempoolStatus::mempool_stats const& stats = snapshot.stats;
+
+    auto const& buckets = MempoolStatus::mempool_stats::fee_per_byte_buckets;
+
+    mstch::array fee_histogram;
+
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        auto const& bucket = stats.fee_histogram[i];
+
+        // show only buckets that have some txs
+        if (bucket.txs_no == 0)
+            continue;
+
+        fee_histogram.push_back(mstch::map {
+                {"fee_per_byte_min", buckets[i]},
+                {"fee_per_byte_max", i + 1 < buckets.size()
+                                     ? std::to_string(buckets[i + 1]) : string {"-"}},
+                {"txs_no"          , bucket.txs_no},
+                {"size_kB"         , fmt::format("{:0.2f}", bucket.size / 1024.0)},
+                {"weight_kB"       , fmt::format("{:0.2f}", bucket.weight / 1024.0)},
+                {"fee"             , xmreg::xmr_amount_to_str(bucket.fee, "{:0.6f}")}
+        });
+    }
+
+    mstch::array ages;
+
+    for (auto const& percentile: mempool_age_percentiles)
+    {
+        uint64_t receive_time = snapshot.receive_time_percentile(percentile.second);
+
+        ages.push_back(mstch::map {
+                {"percentile", percentile.first},
+                {"age"       , get_age(current_timestamp,
+                                       std::min(receive_time, current_timestamp)).first}
+        });
+    }
+
+    context["mempool_stats"] = mstch::map {
+            {"total_weight_kB", fmt::format("{:0.2f}", stats.total_weight / 1024.0)},
+            {"total_fee"      , xmreg::xmr_amount_to_str(stats.total_fee, "{:0.6f}")},
+            {"fee_histogram"  , fee_histogram},
+            {"age_percentiles", ages},
+            {"have_txs"       , !snapshot.empty()}
+    };
+}
+
+static string
+mempool_render_key(bool add_header_and_footer, uint64_t no_of_mempool_tx)
+{
+    return add_header_and_footer
+           ? string {"full_page"}
+           : "front_page_" + std::to_string(no_of_mempool_tx);
+}
+
 
 string
 get_payment_id_as_string(
@@ -5884,128 +6560,210 @@ find_our_outputs(
         json& j_outptus,
         string& error_msg)
 {
+    RequestTimings::phase decoding {RequestTimings::decode};
+
+    // spend public key is precomputed only once
+    // for all the txs that we are going to scan
+    ScanKernel scan_kernel {address.m_spend_public_key};
+
+    if (!scan_kernel.is_valid())
+    {
+        error_msg = "Cant use public spend key of the address";
+        return false;
+    }
+
+    vector<transaction const*> txs;
+    vector<tx_details> txds;
+
+    // public tx keys of all the txs. For each tx,
+    // its main key is followed by its additional keys
+    vector<public_key> tx_pub_keys;
+
+    // position of main public key of each tx in tx_pub_keys
+    vector<size_t> tx_pub_keys_offset;
 
-    // for each tx, perform output search using provided
-    // address and viewkey
     for (auto it = txs_begin; it != txs_end; ++it)
     {
-        cryptonote::transaction const& tx = *it;
+        txs.push_back(&(*it));
+        txds.push_back(get_tx_details(*it));
 
-        tx_details txd = get_tx_details(tx);
+        tx_details const& txd = txds.back();
+
+        tx_pub_keys_offset.push_back(tx_pub_keys.size());
+
+        tx_pub_keys.push_back(txd.pk);
+        tx_pub_keys.insert(tx_pub_keys.end(),
+                           txd.additional_pks.begin(),
+                           txd.additional_pks.end());
+    }
+
+    // public transaction keys are combined with our viewkey
+    // to create, so called, derived keys.
+    vector<key_derivation> derivations;
+
+    if (!ScanKernel::generate_key_derivations(
+            tx_pub_keys, prv_view_key, derivations))
+    {
+        error_msg = "Cant calculate key_derivation";
+        return false;
+    }
+
+    // for each output of each tx: 0 - not ours,
+    // 1 - ours using main derivation, 2 - ours using additional one
+    vector<vector<uint8_t>> ours_outputs(txds.size());
 
-        // public transaction key is combined with our viewkey
-        // to create, so called, derived key.
-        key_derivation derivation;
+    for (size_t tx_no = 0; tx_no < txds.size(); ++tx_no)
+        ours_outputs[tx_no].resize(txds[tx_no].output_pub_keys.size(), 0);
 
-        if (!generate_key_derivation(txd.pk, prv_view_key, derivation))
+    vector<key_derivation> batch_derivations;
+    vector<uint64_t> batch_output_indices;
+    vector<pair<size_t, size_t>> batch_items; // tx_no, output_idx
+    vector<public_key> derived_keys;
+
+    auto derive_and_match = [&](uint8_t match_type) -> bool
+    {
+        // get the tx output public keys
+        // that normally would be generated for us,
+        // if someone had sent us some xmr.
+        if (!scan_kernel.derive_public_keys(batch_derivations,
+                                            batch_output_indices,
+                                            derived_keys))
         {
-            error_msg = "Cant calculate key_derivation";
+            error_msg = "Cant derive public keys of outputs";
             return false;
         }
 
-        std::vector<key_derivation> additional_derivations(txd.additional_pks.size());
-        for (size_t i = 0; i < txd.additional_pks.size(); ++i)
+        // check if generated public key matches the current output's key
+        for (size_t i = 0; i < batch_items.size(); ++i)
         {
-            if (!generate_key_derivation(txd.additional_pks[i], prv_view_key, additional_derivations[i]))
+            size_t tx_no      = batch_items[i].first;
+            size_t output_idx = batch_items[i].second;
+
+            if (std::get<0>(txds[tx_no].output_pub_keys[output_idx])
+                    == derived_keys[i])
             {
-                error_msg = "Cant calculate key_derivation";
-                return false;
+                ours_outputs[tx_no][output_idx] = match_type;
             }
         }
 
-        uint64_t output_idx{0};
+        batch_derivations.clear();
+        batch_output_indices.clear();
+        batch_items.clear();
 
-        std::vector<uint64_t> money_transfered(tx.vout.size(), 0);
+        return true;
+    };
+
+    // first, all outputs of all txs using main derivations
+    for (size_t tx_no = 0; tx_no < txds.size(); ++tx_no)
+    {
+        for (size_t output_idx = 0;
+             output_idx < txds[tx_no].output_pub_keys.size();
+             ++output_idx)
+        {
+            batch_derivations.push_back(derivations[tx_pub_keys_offset[tx_no]]);
+            batch_output_indices.push_back(output_idx);
+            batch_items.emplace_back(tx_no, output_idx);
+        }
+    }
+
+    if (!derive_and_match(1))
+        return false;
+
+    // then, outputs which are not ours are checked
+    // again using additional derivations, if tx has them
+    for (size_t tx_no = 0; tx_no < txds.size(); ++tx_no)
+    {
+        tx_details const& txd = txds[tx_no];
 
-        //j_data["outputs"] = json::array();
-        //json& j_outptus   = j_data["outputs"];
+        if (txd.additional_pks.size() != txd.output_pub_keys.size())
+            continue;
 
-        for (output_tuple_with_tag &outp: txd.output_pub_keys)
+        for (size_t output_idx = 0;
+             output_idx < txd.output_pub_keys.size();
+             ++output_idx)
         {
+            if (ours_outputs[tx_no][output_idx] != 0)
+                continue;
 
-            // get the tx output public key
-            // that normally would be generated for us,
-            // if someone had sent us some xmr.
-            public_key tx_pubkey;
+            batch_derivations.push_back(
+                    derivations[tx_pub_keys_offset[tx_no] + 1 + output_idx]);
+            batch_output_indices.push_back(output_idx);
+            batch_items.emplace_back(tx_no, output_idx);
+        }
+    }
 
-            derive_public_key(derivation,
-                              output_idx,
-                              address.m_spend_public_key,
-                              tx_pubkey);
+    if (!derive_and_match(2))
+        return false;
 
-            // check if generated public key matches the current output's key
-            bool mine_output = (std::get<0>(outp) == tx_pubkey);
-            bool with_additional = false;
-            if (!mine_output && txd.additional_pks.size() == txd.output_pub_keys.size())
-            {
-                derive_public_key(additional_derivations[output_idx],
-                                  output_idx,
-                                  address.m_spend_public_key,
-                                  tx_pubkey);
-                mine_output = (std::get<0>(outp) == tx_pubkey);
-                with_additional = true;
-            }
+    // for each tx, decode amounts of outputs found
+    for (size_t tx_no = 0; tx_no < txds.size(); ++tx_no)
+    {
+        cryptonote::transaction const& tx = *txs[tx_no];
 
-            uint64_t xmr_amount = std::get<1>(outp);
+        tx_details const& txd = txds[tx_no];
 
-            // if mine output has RingCT, i.e., tx version is 2
-            if (mine_output && tx.version == 2)
-            {
-                // cointbase txs have amounts in plain sight.
-                // so use amount from ringct, only for non-coinbase txs
-                if (!is_coinbase(tx))
-                {
+        std::vector<uint64_t> money_transfered(tx.vout.size(), 0);
 
-                    // initialize with regular amount
-                    uint64_t rct_amount = money_transfered[output_idx];
+        for (size_t output_idx = 0;
+             output_idx < txd.output_pub_keys.size();
+             ++output_idx)
+        {
+            uint8_t match_type = ours_outputs[tx_no][output_idx];
 
-                    bool r {false};
+            if (match_type == 0)
+                continue;
 
-                    rct::key mask = tx.rct_signatures.ecdhInfo[output_idx].mask;
+            output_tuple_with_tag const& outp = txd.output_pub_keys[output_idx];
+
+            uint64_t xmr_amount = std::get<1>(outp);
+
+            // if mine output has RingCT, i.e., tx version is 2
+            // cointbase txs have amounts in plain sight.
+            // so use amount from ringct, only for non-coinbase txs
+            if (tx.version == 2 && !is_coinbase(tx))
+            {
+                // initialize with regular amount
+                uint64_t rct_amount = money_transfered[output_idx];
 
-                    auto derivation_to_use = with_additional
-                            ? additional_derivations[output_idx] : derivation;
+                rct::key mask = tx.rct_signatures.ecdhInfo[output_idx].mask;
 
-                    r = decode_ringct(tx.rct_signatures,
-                                      derivation_to_use,
-                                      output_idx,
-                                      mask,
-                                      rct_amount);
+                key_derivation const& derivation_to_use = match_type == 2
+                        ? derivations[tx_pub_keys_offset[tx_no] + 1 + output_idx]
+                        : derivations[tx_pub_keys_offset[tx_no]];
 
-                    if (!r)
-                    {
-                        error_msg = "Cant decode ringct for tx: "
-                                                + pod_to_hex(txd.hash);
-                        return false;
-                    }
+                bool r = decode_ringct(tx.rct_signatures,
+                                       derivation_to_use,
+                                       output_idx,
+                                       mask,
+                                       rct_amount);
 
-                    xmr_amount = rct_amount;
-                    money_transfered[output_idx] = rct_amount;
+                if (!r)
+                {
+                    error_msg = "Cant decode ringct for tx: "
+                                            + pod_to_hex(txd.hash);
+                    return false;
+                }
 
-                } // if (!is_coinbase(tx))
+                xmr_amount = rct_amount;
+                money_transfered[output_idx] = rct_amount;
 
-            }  // if (mine_output && tx.version == 2)
+            }  // if (tx.version == 2 && !is_coinbase(tx))
 
-            if (mine_output)
-            {
-                string payment_id_str = get_payment_id_as_string(txd, prv_view_key);
-
-                j_outptus.push_back(json {
-                        {"output_pubkey" , pod_to_hex(std::get<0>(outp))},
-                        {"amount"        , xmr_amount},
-                        {"block_no"      , block_no},
-                        {"in_mempool"    , is_mempool},
-                        {"output_idx"    , output_idx},
-                        {"tx_hash"       , pod_to_hex(txd.hash)},
-                        {"payment_id"    , payment_id_str}
-                });
-            }
+            string payment_id_str = get_payment_id_as_string(txd, prv_view_key);
 
-            ++output_idx;
+            j_outptus.push_back(json {
+                    {"output_pubkey" , pod_to_hex(std::get<0>(outp))},
+                    {"amount"        , xmr_amount},
+                    {"block_no"      , block_no},
+                    {"in_mempool"    , is_mempool},
+                    {"output_idx"    , output_idx},
+                    {"tx_hash"       , pod_to_hex(txd.hash)},
+                    {"payment_id"    , payment_id_str}
+            });
 
-        } //  for (pair<public_key, uint64_t>& outp: txd.output_pub_keys)
+        } //  for (size_t output_idx = 0; ...
 
-    } // for (auto it = blk_txs.begin(); it != blk_txs.end(); ++it)
+    } // for (size_t tx_no = 0; tx_no < txds.size(); ++tx_no)
 
     return true;
 }
@@ -6055,7 +6813,7 @@ find_tx(const crypto::hash& tx_hash,
         if (!found_txs.empty())
         {
             // there should be only one tx found
-            tx = found_txs.at(0).tx;
+            tx = *found_txs.at(0).get_tx();
             found_in_mempool = true;
             tx_timestamp = found_txs.at(0).receive_time;
         }
@@ -6249,6 +7007,8 @@ construct_tx_context(transaction tx, uint16_t with_ring_signatures = 0)
 
     vector<vector<uint64_t>> mixin_timestamp_groups;
 
+    RequestTimings::phase resolving_rings {RequestTimings::rings};
+
     // make timescale maps for mixins in input
     for (const txin_to_key &in_key: txd.input_key_imgs)
     {
@@ -6256,6 +7016,15 @@ construct_tx_context(transaction tx, uint16_t with_ring_signatures = 0)
         if (show_part_of_inputs && (input_idx > max_no_of_inputs_to_show))
             break;
 
+        // client most likely gave up on us already
+        if (RequestDeadline::expired())
+        {
+            context["has_error"] = true;
+            context["error_msg"] = string("Request took too long. "
+                                          "Please try again later.");
+            return context;
+        }
+
         // get absolute offsets of mixins
         std::vector<uint64_t> absolute_offsets
                 = cryptonote::relative_output_offsets_to_absolute(
@@ -6308,7 +7077,9 @@ construct_tx_context(transaction tx, uint16_t with_ring_signatures = 0)
                 {"input_idx"    , fmt::format("{:02d}", input_idx)},
                 {"mixins"       , mstch::array{}},
                 {"ring_sigs"    , mstch::array{}},
-                {"already_spent", false} // placeholder for later
+                {"already_spent", false}, // placeholder for later
+                {"spent_in_mempool", false}, // placeholder for later
+                {"spent_in_mempool_tx", string {}}
         });
 
         if (detailed_view)
@@ -6439,6 +7210,7 @@ construct_tx_context(transaction tx, uint16_t with_ring_signatures = 0)
 
     } // for (const txin_to_key& in_key: txd.input_key_imgs)
 
+    resolving_rings.stop();
 
 
     if (detailed_view)
@@ -6624,6 +7396,8 @@ get_tx_details(const transaction& tx,
                uint64_t blk_height = 0,
                uint64_t bc_height = 0)
 {
+    RequestTimings::phase timer {RequestTimings::tx_details};
+
     tx_details txd;
 
     // get tx hash
@@ -6756,33 +7530,39 @@ search_mempool(crypto::hash tx_hash,
 {
     // if tx_hash == null_hash then this method
     // will just return the vector containing all
-    // txs in mempool
+    // txs in mempool. Their full txs are not loaded.
 
+    // get mempool snapshot from mempoolstatus thread (shared_ptr avoids deep copy)
+    auto snapshot = MempoolStatus::get_mempool_snapshot();
 
+    if (tx_hash == null_hash)
+    {
+        for (size_t row = 0; row < snapshot->size(); ++row)
+            found_txs.push_back(snapshot->tx(row));
 
-    // get mempool tx from mempoolstatus thread (shared_ptr avoids deep copy)
-    auto mempool_txs = MempoolStatus::get_mempool_txs();
+        return true;
+    }
 
-    if (!mempool_txs)
+    MempoolStatus::mempool_tx mempool_tx;
+
+    if (!snapshot->find_tx(tx_hash, mempool_tx))
         return true;
 
-    // if dont have tx_blob member, construct tx
-    // from json obtained from the rpc call
+    // full tx could have been dropped from the snapshot. So
+    // we get it here once, and keep it with the found tx, so that
+    // get_tx() of the found tx always returns it.
+    auto full_tx = mempool_tx.get_tx();
 
-    for (size_t i = 0; i < mempool_txs->size(); ++i)
+    if (!full_tx)
     {
-        // get transaction info of the tx in the mempool
-        const MempoolStatus::mempool_tx& mempool_tx = mempool_txs->at(i);
-
-        if (tx_hash == mempool_tx.tx_hash || tx_hash == null_hash)
-        {
-            found_txs.push_back(mempool_tx);
+        // tx left the mempool in the meantime
+        return true;
+    }
 
-            if (tx_hash != null_hash)
-                break;
-        }
+    mempool_tx.full_tx = std::make_shared<MempoolStatus::mempool_full_tx>(
+            tx_hash, std::move(full_tx));
 
-    } // for (size_t i = 0; i < mempool_txs->size(); ++i)
+    found_txs.push_back(std::move(mempool_tx));
 
     return true;
 }
@@ -6973,6 +7753,18 @@ add_css_style(mstch::map& context)
     }};
 }
 
+void
+add_live_updates(mstch::map& context)
+{
+    // autorefresh pages get the script instead of being
+    // reloaded every 10 seconds
+    context["live_updates"] = enable_live_updates;
+
+    context["live_updates_js"] = mstch::lambda{[&](const std::string& text) -> mstch::node {
+        return template_file["live_updates_js"];
+    }};
+}
+
 bool
 get_tx(string const& tx_hash_str,
        transaction& tx,
@@ -7002,7 +7794,7 @@ get_tx(string const& tx_hash_str,
             return false;
         }
 
-        tx = found_txs.at(0).tx;
+        tx = *found_txs.at(0).get_tx();
     }
 
     return true;
@@ -7083,6 +7875,12 @@ typename std::enable_if<
     HasSpanInGetOutputKeyT<T>::value, void>::type
 get_output_key(uint64_t amount, Args&&... args)
 {
+  static Metrics::counter& reads = Metrics::lmdb_reads.get("get_output_key");
+
+  reads.inc();
+
+  RequestTimings::phase timer {RequestTimings::db};
+
   core_storage->get_db().get_output_key(
           epee::span<const uint64_t>(&amount, 1), 
           std::forward<Args>(args)...);
@@ -7093,6 +7891,12 @@ typename std::enable_if<
     !HasSpanInGetOutputKeyT<T>::value, void>::type
 get_output_key(uint64_t amount, Args&&... args)
 {
+  static Metrics::counter& reads = Metrics::lmdb_reads.get("get_output_key");
+
+  reads.inc();
+
+  RequestTimings::phase timer {RequestTimings::db};
+
   core_storage->get_db().get_output_key(
           amount, std::forward<Args>(args)...);
 }
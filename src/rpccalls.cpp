@@ -8,57 +8,181 @@ namespace xmreg
 {
 
 
+uint64_t rpccalls::default_timeout {15000};
+size_t rpccalls::default_max_connections {4};
+uint64_t rpccalls::cache_ttl {1000};
+
+rpccalls::results_cache rpccalls::cache;
+
 rpccalls::rpccalls(
          string _daemon_url,
-         login_opt login,
-         uint64_t _timeout)
+         login_opt _login,
+         uint64_t _timeout,
+         size_t _max_connections)
         : daemon_url {_daemon_url},
-          timeout_time {_timeout}
+          timeout_time {_timeout > 0 ? _timeout : default_timeout},
+          login {_login},
+          max_connections {_max_connections > 0
+                           ? _max_connections : default_max_connections}
 {
     epee::net_utils::parse_url(daemon_url, url);
 
     port = std::to_string(url.port);
 
-    timeout_time_ms = std::chrono::milliseconds {timeout_time};    
+    timeout_time_ms = std::chrono::milliseconds {timeout_time};
+
+    max_connections = std::max<size_t>(max_connections, 1);
+
+    idle_connections.reserve(max_connections);
+}
+
+unique_ptr<rpccalls::connection>
+rpccalls::acquire_connection()
+{
+    std::unique_lock<std::mutex> lck (pool_mutx);
+
+    // wait for idle connection or for a free slot
+    // to make a new one, but no longer than the timeout
+    bool got_one = pool_cv.wait_for(lck, timeout_time_ms, [this]()
+    {
+        return !idle_connections.empty()
+               || no_of_connections < max_connections;
+    });
+
+    if (!got_one)
+        return nullptr;
+
+    if (!idle_connections.empty())
+    {
+        unique_ptr<connection> conn = std::move(idle_connections.back());
+        idle_connections.pop_back();
+        return conn;
+    }
+
+    ++no_of_connections;
+
+    lck.unlock();
 
-    m_http_client.set_server(
+    auto conn = make_unique<connection>();
+
+    conn->http_client.set_server(
              daemon_url,
              login,
              epee::net_utils::ssl_support_t::e_ssl_support_disabled);
+
+    return conn;
+}
+
+void
+rpccalls::release_connection(unique_ptr<connection> conn)
+{
+    {
+        std::lock_guard<std::mutex> lck (pool_mutx);
+        idle_connections.push_back(std::move(conn));
+    }
+
+    pool_cv.notify_one();
 }
 
 bool
-rpccalls::connect_to_monero_daemon()
+rpccalls::connect(connection& conn)
 {
-    //std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
+    if (conn.http_client.is_connected())
+        return true;
 
-    if(m_http_client.is_connected())
     {
-        return true;
+        std::lock_guard<std::mutex> lck (pool_mutx);
+
+        // daemon failed recently, so dont wait
+        // for it to fail again
+        if (std::chrono::steady_clock::now() < next_connect_time)
+            return false;
+    }
+
+    if (!conn.http_client.connect(timeout_time_ms))
+    {
+        report_failure();
+        return false;
     }
 
-    return m_http_client.connect(timeout_time_ms);
+    return true;
+}
+
+void
+rpccalls::report_failure()
+{
+    std::lock_guard<std::mutex> lck (pool_mutx);
+
+    ++consecutive_failures;
+
+    // 250ms, 500ms, 1s, ... up to max_backoff
+    auto backoff = min_backoff
+            * (uint64_t {1} << std::min<uint64_t>(consecutive_failures - 1, 16));
+
+    next_connect_time = std::chrono::steady_clock::now()
+                        + std::min<std::chrono::milliseconds>(backoff, max_backoff);
+}
+
+void
+rpccalls::report_success()
+{
+    std::lock_guard<std::mutex> lck (pool_mutx);
+
+    consecutive_failures = 0;
+    next_connect_time = std::chrono::steady_clock::time_point {};
+}
+
+bool
+rpccalls::connect_to_monero_daemon()
+{
+    unique_ptr<connection> conn = acquire_connection();
+
+    if (!conn)
+        return false;
+
+    bool r = connect(*conn);
+
+    if (r)
+        report_success();
+
+    release_connection(std::move(conn));
+
+    return r;
+}
+
+bool
+rpccalls::is_daemon_healthy()
+{
+    std::lock_guard<std::mutex> lck (pool_mutx);
+    return consecutive_failures == 0;
 }
 
 
 bool
 rpccalls::get_base_fee_estimate(uint64_t grace_blocks,
-                                uint64_t& fee_estimate) {
+                                uint64_t& fee_estimate)
+{
+    return single_flight(cache.fee_estimates,
+                         daemon_url + "/get_fee_estimate/"
+                         + std::to_string(grace_blocks),
+                         fee_estimate,
+                         [&](uint64_t& fee)
+                         {
+                             return fetch_base_fee_estimate(grace_blocks, fee);
+                         });
+}
+
+bool
+rpccalls::fetch_base_fee_estimate(uint64_t grace_blocks,
+                                  uint64_t& fee_estimate) {
 
     cryptonote::COMMAND_RPC_GET_BASE_FEE_ESTIMATE::request req;
     cryptonote::COMMAND_RPC_GET_BASE_FEE_ESTIMATE::response res;
 
     req.grace_blocks = grace_blocks;
 
-    if (!connect_to_monero_daemon())
-    {
-        cerr << "get_base_fee_estimate: not connected to daemon" << endl;
-        return false;
-    }
-
-    bool r = epee::net_utils::invoke_http_json(
-            "/get_fee_estimate",
-            req, res, m_http_client, timeout_time_ms);
+    bool r = invoke_http_json("/get_fee_estimate", req, res,
+                              "get_base_fee_estimate");
 
     fee_estimate = res.fee;
 
@@ -73,17 +197,8 @@ rpccalls::get_current_height()
     COMMAND_RPC_GET_HEIGHT::request   req;
     COMMAND_RPC_GET_HEIGHT::response  res;
 
-    std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-    if (!connect_to_monero_daemon())
-    {
-        cerr << "get_current_height: not connected to daemon" << endl;
-        return false;
-    }
-
-    bool r = epee::net_utils::invoke_http_json(
-            "/getheight",
-            req, res, m_http_client, timeout_time_ms);
+    bool r = invoke_http_json("/getheight", req, res,
+                              "get_current_height");
 
     if (!r)
     {
@@ -102,21 +217,8 @@ rpccalls::get_mempool(vector<tx_info>& mempool_txs)
     COMMAND_RPC_GET_TRANSACTION_POOL::request  req;
     COMMAND_RPC_GET_TRANSACTION_POOL::response res;
 
-    bool r;
-
-    {
-        std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-        if (!connect_to_monero_daemon())
-        {
-            cerr << "get_mempool: not connected to daemon" << endl;
-            return false;
-        }
-
-        r = epee::net_utils::invoke_http_json(
-                "/get_transaction_pool",
-                req, res, m_http_client, timeout_time_ms);
-    }
+    bool r = invoke_http_json("/get_transaction_pool", req, res,
+                              "get_mempool");
 
     if (!r || res.status != CORE_RPC_STATUS_OK)
     {
@@ -152,17 +254,8 @@ rpccalls::commit_tx(tools::wallet2::pending_tx& ptx, string& error_msg)
 
     req.do_not_relay = false;
 
-    std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-    if (!connect_to_monero_daemon())
-    {
-        cerr << "commit_tx: not connected to daemon" << endl;
-        return false;
-    }
-
-    bool r = epee::net_utils::invoke_http_json(
-            "/sendrawtransaction",
-            req, res, m_http_client, timeout_time_ms);
+    bool r = invoke_http_json("/sendrawtransaction", req, res,
+                              "commit_tx");
 
     if (!r || res.status == "Failed")
     {
@@ -177,6 +270,16 @@ rpccalls::commit_tx(tools::wallet2::pending_tx& ptx, string& error_msg)
 
 bool
 rpccalls::get_network_info(COMMAND_RPC_GET_INFO::response& response)
+{
+    return single_flight(cache.network_info, daemon_url, response,
+                         [&](COMMAND_RPC_GET_INFO::response& info)
+                         {
+                             return fetch_network_info(info);
+                         });
+}
+
+bool
+rpccalls::fetch_network_info(COMMAND_RPC_GET_INFO::response& response)
 {
 
     epee::json_rpc::request<cryptonote::COMMAND_RPC_GET_INFO::request>
@@ -190,19 +293,8 @@ rpccalls::get_network_info(COMMAND_RPC_GET_INFO::response& response)
     req_t.id = epee::serialization::storage_entry(0);
     req_t.method = "get_info";
 
-    {
-        std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-        if (!connect_to_monero_daemon())
-        {
-            cerr << "get_network_info: not connected to daemon" << endl;
-            return false;
-        }
-
-        r = epee::net_utils::invoke_http_json("/json_rpc",
-                                              req_t, resp_t,
-                                              m_http_client);
-    }
+    r = invoke_http_json("/json_rpc", req_t, resp_t,
+                         "get_network_info");
 
     string err;
 
@@ -239,6 +331,16 @@ rpccalls::get_network_info(COMMAND_RPC_GET_INFO::response& response)
 
 bool
 rpccalls::get_hardfork_info(COMMAND_RPC_HARD_FORK_INFO::response& response)
+{
+    return single_flight(cache.hardfork_info, daemon_url, response,
+                         [&](COMMAND_RPC_HARD_FORK_INFO::response& info)
+                         {
+                             return fetch_hardfork_info(info);
+                         });
+}
+
+bool
+rpccalls::fetch_hardfork_info(COMMAND_RPC_HARD_FORK_INFO::response& response)
 {
     epee::json_rpc::request<cryptonote::COMMAND_RPC_HARD_FORK_INFO::request> req_t = AUTO_VAL_INIT(req_t);
     epee::json_rpc::response<cryptonote::COMMAND_RPC_HARD_FORK_INFO::response, std::string> resp_t = AUTO_VAL_INIT(resp_t);
@@ -250,19 +352,8 @@ rpccalls::get_hardfork_info(COMMAND_RPC_HARD_FORK_INFO::response& response)
     req_t.id = epee::serialization::storage_entry(0);
     req_t.method = "hard_fork_info";
 
-    {
-        std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-        if (!connect_to_monero_daemon())
-        {
-            cerr << "get_hardfork_info: not connected to daemon" << endl;
-            return false;
-        }
-
-        r = epee::net_utils::invoke_http_json("/json_rpc",
-                                              req_t, resp_t,
-                                              m_http_client);
-    }
+    r = invoke_http_json("/json_rpc", req_t, resp_t,
+                         "get_hardfork_info");
 
 
     string err;
@@ -304,6 +395,22 @@ rpccalls::get_dynamic_per_kb_fee_estimate(
         uint64_t grace_blocks,
         uint64_t& fee,
         string& error_msg)
+{
+    return single_flight(cache.fee_estimates,
+                         daemon_url + "/json_rpc/get_fee_estimate/"
+                         + std::to_string(grace_blocks),
+                         fee,
+                         [&](uint64_t& fee_estimate)
+                         {
+                             return fetch_dynamic_per_kb_fee_estimate(
+                                     grace_blocks, fee_estimate);
+                         });
+}
+
+bool
+rpccalls::fetch_dynamic_per_kb_fee_estimate(
+        uint64_t grace_blocks,
+        uint64_t& fee)
 {
     epee::json_rpc::request<COMMAND_RPC_GET_BASE_FEE_ESTIMATE::request>
             req_t = AUTO_VAL_INIT(req_t);
@@ -318,19 +425,8 @@ rpccalls::get_dynamic_per_kb_fee_estimate(
 
     bool r {false};
 
-    {
-        std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-        if (!connect_to_monero_daemon())
-        {
-            cerr << "get_dynamic_per_kb_fee_estimate: not connected to daemon" << endl;
-            return false;
-        }
-
-        r = epee::net_utils::invoke_http_json("/json_rpc",
-                                              req_t, resp_t,
-                                              m_http_client);
-    }
+    r = invoke_http_json("/json_rpc", req_t, resp_t,
+                         "get_dynamic_per_kb_fee_estimate");
 
     string err;
 
@@ -381,19 +477,8 @@ rpccalls::get_block(string const& blk_hash, block& blk, string& error_msg)
 
     bool r {false};
 
-    {
-        std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-        if (!connect_to_monero_daemon())
-        {
-            cerr << "get_block: not connected to daemon" << endl;
-            return false;
-        }
-
-        r = epee::net_utils::invoke_http_json("/json_rpc",
-                                              req_t, resp_t,
-                                              m_http_client);
-    }
+    r = invoke_http_json("/json_rpc", req_t, resp_t,
+                         "get_block");
 
     string err;
 
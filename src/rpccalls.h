@@ -10,7 +10,14 @@
 
 #include "wipeable_string.h"
 
+#include "Metrics.h"
+
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <future>
+#include <map>
 #include <utility>
 
 
@@ -69,6 +76,28 @@ using namespace std;
 
 class rpccalls
 {
+public:
+
+    using login_opt = boost::optional<epee::net_utils::http::login>;
+
+    // used when no timeout or number of connections
+    // is given to the constructor
+    static uint64_t default_timeout;
+    static size_t default_max_connections;
+
+    // how long results of get_info, hard_fork_info and
+    // fee estimates are reused. 0 disables caching, but
+    // concurrent identical calls are still coalesced.
+    static uint64_t cache_ttl;
+
+private:
+
+    // single connection to the daemon
+    struct connection
+    {
+        epee::net_utils::http::http_simple_client http_client;
+    };
+
     string daemon_url ;
     uint64_t timeout_time;
 
@@ -76,23 +105,237 @@ class rpccalls
 
     epee::net_utils::http::url_content url;
 
-    epee::net_utils::http::http_simple_client m_http_client;
-
-    std::mutex m_daemon_rpc_mutex;
+    login_opt login;
 
     string port;
 
-public:
+    // Pool of connections, so that concurrent calls, e.g.,
+    // from different page requests and from the mempool thread,
+    // dont wait for each other. Connections are made
+    // lazily, up to max_connections.
+    size_t max_connections;
 
-    using login_opt = boost::optional<epee::net_utils::http::login>;
+    vector<unique_ptr<connection>> idle_connections;
+
+    size_t no_of_connections {0};
+
+    std::mutex pool_mutx;
+    std::condition_variable pool_cv;
+
+    // when daemon fails, new connections are not tried
+    // before next_connect_time, which is pushed further
+    // with each consecutive failure, up to max_backoff.
+    // This way calls fail fast when daemon is down, instead
+    // of each of them waiting for connection timeout.
+    static constexpr std::chrono::milliseconds min_backoff {250};
+    static constexpr std::chrono::milliseconds max_backoff {30000};
+
+    uint64_t consecutive_failures {0};
+
+    std::chrono::steady_clock::time_point next_connect_time;
+
+    unique_ptr<connection>
+    acquire_connection();
+
+    void
+    release_connection(unique_ptr<connection> conn);
+
+    bool
+    connect(connection& conn);
+
+    void
+    report_failure();
+
+    void
+    report_success();
+
+    /**
+     * Makes a http json call using a pooled connection.
+     * Connection which failed is disconnected, so that it
+     * reconnects when used next time.
+     */
+    template <typename Request, typename Response>
+    bool
+    invoke_http_json(string const& uri,
+                     Request const& req, Response& resp,
+                     char const* caller)
+    {
+        unique_ptr<connection> conn = acquire_connection();
+
+        if (!conn)
+        {
+            cerr << caller << ": no free connection to daemon" << endl;
+            return false;
+        }
+
+        if (!connect(*conn))
+        {
+            cerr << caller << ": not connected to daemon" << endl;
+            release_connection(std::move(conn));
+            return false;
+        }
+
+        auto start = Metrics::clock::now();
+
+        bool r = epee::net_utils::invoke_http_json(
+                uri, req, resp, conn->http_client, timeout_time_ms);
+
+        Metrics::rpc_call_duration.get(caller)
+                .observe(Metrics::elapsed_us(start));
+
+        if (r)
+        {
+            report_success();
+        }
+        else
+        {
+            Metrics::rpc_errors.get(caller).inc();
+
+            conn->http_client.disconnect();
+            report_failure();
+        }
+
+        release_connection(std::move(conn));
+
+        return r;
+    }
+
+    // last result of a call and the call in progress, if any
+    template <typename T>
+    struct cached_result
+    {
+        bool has_value {false};
+        T value;
+        std::chrono::steady_clock::time_point fetched_at;
+
+        std::shared_future<std::pair<bool, T>> in_flight;
+    };
+
+    // Results are shared by all rpccalls objects, as the page
+    // and the mempool thread have their own ones. They are
+    // keyed by daemon url, and by grace blocks for fee estimates.
+    struct results_cache
+    {
+        std::mutex cache_mutx;
+
+        map<string, cached_result<COMMAND_RPC_GET_INFO::response>> network_info;
+        map<string, cached_result<COMMAND_RPC_HARD_FORK_INFO::response>> hardfork_info;
+        map<string, cached_result<uint64_t>> fee_estimates;
+    };
+
+    static results_cache cache;
+
+    /**
+     * Returns cached result if it is not older than cache_ttl.
+     * Otherwise, if the same call is already in progress, waits
+     * for its result. If not, calls fetch and shares its
+     * result with the callers which came in the meantime.
+     * Failed calls are not cached.
+     */
+    template <typename T, typename Fetch>
+    bool
+    single_flight(map<string, cached_result<T>>& results,
+                  string const& key, T& result, Fetch fetch)
+    {
+        std::unique_lock<std::mutex> lck (cache.cache_mutx);
+
+        cached_result<T>& cached = results[key];
+
+        if (cached.in_flight.valid())
+        {
+            Metrics::add_cache_access("daemon_rpc", true);
+
+            auto in_flight = cached.in_flight;
+
+            lck.unlock();
+
+            std::pair<bool, T> const& r = in_flight.get();
+
+            if (r.first)
+                result = r.second;
+
+            return r.first;
+        }
+
+        if (cached.has_value
+                && std::chrono::steady_clock::now() - cached.fetched_at
+                   < std::chrono::milliseconds {cache_ttl})
+        {
+            Metrics::add_cache_access("daemon_rpc", true);
+
+            result = cached.value;
+            return true;
+        }
+
+        Metrics::add_cache_access("daemon_rpc", false);
+
+        std::promise<std::pair<bool, T>> promise;
+
+        cached.in_flight = promise.get_future().share();
+
+        lck.unlock();
+
+        T value {};
+        bool r {false};
+
+        try
+        {
+            r = fetch(value);
+        }
+        catch (std::exception const& e)
+        {
+            cerr << "single_flight: " << e.what() << endl;
+        }
+
+        lck.lock();
+
+        // references to map elements stay valid
+        cached.in_flight = {};
+
+        if (r)
+        {
+            cached.has_value  = true;
+            cached.value      = value;
+            cached.fetched_at = std::chrono::steady_clock::now();
+        }
+
+        lck.unlock();
+
+        promise.set_value({r, value});
+
+        if (r)
+            result = std::move(value);
+
+        return r;
+    }
+
+    bool
+    fetch_network_info(COMMAND_RPC_GET_INFO::response& response);
+
+    bool
+    fetch_hardfork_info(COMMAND_RPC_HARD_FORK_INFO::response& response);
+
+    bool
+    fetch_base_fee_estimate(uint64_t grace_blocks, uint64_t& fee_estimate);
+
+    bool
+    fetch_dynamic_per_kb_fee_estimate(uint64_t grace_blocks, uint64_t& fee);
+
+public:
 
     rpccalls(string _daemon_url = "http:://127.0.0.1:18081",
              login_opt _login = login_opt {},
-             uint64_t _timeout = 200000);
+             uint64_t _timeout = 0,
+             size_t _max_connections = 0);
 
     bool
     connect_to_monero_daemon();
 
+    // false when the last call or connection
+    // to the daemon failed
+    bool
+    is_daemon_healthy();
+
     uint64_t
     get_current_height();
 
@@ -136,19 +379,8 @@ public:
         typename T::request req;
         typename T::response resp;
 
-        {
-            std::lock_guard<std::mutex> guard(m_daemon_rpc_mutex);
-
-            if (!connect_to_monero_daemon())
-            {
-                cerr << "get_alt_blocks: not connected to daemon" << endl;
-                return false;
-            }
-
-            r = epee::net_utils::invoke_http_json("/get_alt_blocks_hashes",
-                                                  req, resp,
-                                                  m_http_client);
-        }
+        r = invoke_http_json("/get_alt_blocks_hashes", req, resp,
+                             "get_alt_blocks");
 
         string err;
 
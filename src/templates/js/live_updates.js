@@ -0,0 +1,139 @@
+// Used only on autorefresh pages, when the explorer runs with
+// --enable-live-updates. Instead of reloading the whole page every
+// 10 seconds, it gets new blocks and mempool changes from /live
+// and patches the page with them.
+(function () {
+
+    var reconnect_delay = 1000;
+
+    // tables are not let to grow beyond what the page had
+    var max_rows = {};
+
+    function cell(row, html) {
+        row.insertCell(-1).innerHTML = html;
+    }
+
+    function tx_link(hash) {
+        return '<a href="/tx/' + hash + '">' + hash + '</a>';
+    }
+
+    // rows are added below the table header, i.e., the first row
+    function new_row(table) {
+        if (!(table.id in max_rows)) {
+            // header and 25 rows, as on the front page
+            max_rows[table.id] = Math.max(table.rows.length, 26);
+        }
+
+        if (table.rows.length > 1 && table.rows.length >= max_rows[table.id]) {
+            table.deleteRow(-1);
+        }
+
+        return table.insertRow(Math.min(1, table.rows.length));
+    }
+
+    function on_block(blk) {
+        var blocks = document.getElementById("blocks");
+
+        if (blocks) {
+            var row = new_row(blocks);
+            cell(row, '<a href="/block/' + blk.height + '">' + blk.height + '</a>');
+            cell(row, "00:00:00");
+            cell(row, blk.size);
+            cell(row, blk.no_txs);
+            cell(row, '<a href="/block/' + blk.height + '">new block</a>');
+            cell(row, "");
+            cell(row, "");
+            cell(row, "");
+            cell(row, "");
+        }
+
+        var confirmations = document.querySelectorAll(".confirmations");
+
+        for (var i = 0; i < confirmations.length; i++) {
+            var blk_height = parseInt(confirmations[i].getAttribute("data-blk-height"), 10);
+
+            if (isNaN(blk_height)) {
+                // tx was in the mempool, so it could be in this block
+                location.reload();
+                return;
+            }
+
+            confirmations[i].textContent = blk.height - blk_height + 1;
+        }
+    }
+
+    function on_mempool(mempool) {
+        if (mempool.truncated) {
+            location.reload();
+            return;
+        }
+
+        var no_txs = document.getElementById("mempool_no");
+        var size = document.getElementById("mempool_kB");
+
+        if (no_txs) {
+            no_txs.textContent = mempool.no_txs;
+        }
+
+        if (size) {
+            size.textContent = mempool.size;
+        }
+
+        var table = document.getElementById("mempool_txs");
+
+        if (!table) {
+            return;
+        }
+
+        var removed = {};
+
+        for (var i = 0; i < mempool.removed.length; i++) {
+            removed[mempool.removed[i]] = true;
+        }
+
+        for (var r = table.rows.length - 1; r > 0; r--) {
+            var link = table.rows[r].querySelector("a");
+
+            if (link && removed[link.textContent]) {
+                table.deleteRow(r);
+            }
+        }
+
+        // added txs are from the newest one
+        for (var j = mempool.added.length - 1; j >= 0; j--) {
+            var tx = mempool.added[j];
+            var row = new_row(table);
+            cell(row, "00:00:00");
+            cell(row, tx_link(tx.hash));
+            cell(row, tx.fee + "/" + tx.payed_for_kB);
+            cell(row, tx.no_inputs + "/" + tx.no_outputs);
+            cell(row, tx.txsize);
+        }
+    }
+
+    function connect() {
+        var scheme = location.protocol === "https:" ? "wss://" : "ws://";
+        var ws = new WebSocket(scheme + location.host + "/live");
+
+        ws.onopen = function () {
+            reconnect_delay = 1000;
+        };
+
+        ws.onmessage = function (msg) {
+            var event = JSON.parse(msg.data);
+
+            if (event.type === "block") {
+                on_block(event);
+            } else if (event.type === "mempool") {
+                on_mempool(event);
+            }
+        };
+
+        ws.onclose = function () {
+            setTimeout(connect, reconnect_delay);
+            reconnect_delay = Math.min(reconnect_delay * 2, 60000);
+        };
+    }
+
+    document.addEventListener("DOMContentLoaded", connect);
+})();
@@ -0,0 +1,439 @@
+//
+// Created on 18/10/26.
+//
+// Local stand-in for monerod's http and json-rpc interface, so that
+// the explorer's daemon rpc calls (network info, fee estimates,
+// sendrawtransaction, alt blocks, ...) can be tested and load tested
+// without a real daemon, e.g.,
+//
+//   xmrblocks-mock-daemon 28081 script.json 200 0.05
+//   xmrblocks --daemon-url 127.0.0.1:28081
+//
+// Every call waits latency_ms (+/- latency_jitter_ms), and fails with
+// error_rate probability. Responses, latencies and errors can be
+// scripted per json-rpc method or per http path in a json file:
+//
+// {
+//   "height": 3000000,
+//   "latency_ms": 50,
+//   "latency_jitter_ms": 20,
+//   "error_rate": 0.0,
+//   "hang_ms": 60000,
+//   "calls": {
+//     "get_info": {"latency_ms": 500},
+//     "hard_fork_info": [
+//       {"response": {"version": 16, "enabled": true, "status": "OK"}},
+//       {"error": "busy"},
+//       {"error": "http_500"}
+//     ],
+//     "/getheight": {"response": {"height": 123, "status": "OK"}}
+//   }
+// }
+//
+// A list of steps is served in turn, starting again from the first one
+// after the last. Step without "response" uses the built-in response.
+// Errors are:
+//   http_500   - http 500 status
+//   busy       - status BUSY, as monerod does when it is syncing
+//   malformed  - response which is not json
+//   timeout    - response after hang_ms, for testing rpc timeouts
+//
+// Number of calls of each method or path are at /mock/stats.
+//
+// usage: xmrblocks-mock-daemon [port] [script.json] [latency_ms] [error_rate] [threads]
+//
+
+#include "../ext/crow_all.h"
+#include "../ext/json.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+using json = nlohmann::json;
+
+namespace
+{
+
+struct call_script
+{
+    // steps served in turn
+    vector<json> steps;
+
+    size_t next_step {0};
+
+    uint64_t no_of_calls {0};
+};
+
+struct mock_daemon
+{
+    uint64_t height {3000000};
+
+    uint64_t latency_ms {0};
+    uint64_t latency_jitter_ms {0};
+    uint64_t hang_ms {60000};
+
+    double error_rate {0.0};
+
+    mutex mock_mutx;
+
+    map<string, call_script> calls;
+
+    mt19937_64 rng {random_device{}()};
+
+    bool
+    load_script(string const& script_path);
+
+    // what the daemon would normally return for the method or path
+    json
+    default_response(string const& call) const;
+
+    crow::response
+    handle(crow::request const& req);
+
+    json
+    stats();
+};
+
+bool
+mock_daemon::load_script(string const& script_path)
+{
+    ifstream script_file {script_path};
+
+    if (!script_file)
+    {
+        cerr << "Cant open script " << script_path << endl;
+        return false;
+    }
+
+    json script;
+
+    try
+    {
+        script_file >> script;
+
+        height            = script.value("height", height);
+        latency_ms        = script.value("latency_ms", latency_ms);
+        latency_jitter_ms = script.value("latency_jitter_ms", latency_jitter_ms);
+        hang_ms           = script.value("hang_ms", hang_ms);
+        error_rate        = script.value("error_rate", error_rate);
+
+        if (script.count("calls"))
+        {
+            for (auto const& call: script["calls"].items())
+            {
+                call_script& cs = calls[call.key()];
+
+                if (call.value().is_array())
+                {
+                    for (json const& step: call.value())
+                        cs.steps.push_back(step);
+                }
+                else
+                {
+                    cs.steps.push_back(call.value());
+                }
+            }
+        }
+    }
+    catch (json::exception const& e)
+    {
+        cerr << "Cant parse script " << script_path
+             << ": " << e.what() << endl;
+        return false;
+    }
+
+    return true;
+}
+
+json
+mock_daemon::default_response(string const& call) const
+{
+    if (call == "get_info")
+    {
+        return json {
+            {"height", height},
+            {"target_height", height},
+            {"difficulty", 300000000000},
+            {"target", 120},
+            {"tx_count", 30000000},
+            {"tx_pool_size", 0},
+            {"alt_blocks_count", 0},
+            {"outgoing_connections_count", 12},
+            {"incoming_connections_count", 0},
+            {"white_peerlist_size", 1000},
+            {"grey_peerlist_size", 5000},
+            {"mainnet", true},
+            {"testnet", false},
+            {"stagenet", false},
+            {"nettype", "mainnet"},
+            {"top_block_hash", string(64, '0')},
+            {"cumulative_difficulty", 400000000000000000},
+            {"block_size_limit", 600000},
+            {"block_weight_limit", 600000},
+            {"block_size_median", 300000},
+            {"block_weight_median", 300000},
+            {"start_time", 0},
+            {"free_space", 100000000000},
+            {"offline", false},
+            {"untrusted", false},
+            {"database_size", 200000000000},
+            {"update_available", false},
+            {"version", "mock"},
+            {"status", "OK"}};
+    }
+    else if (call == "hard_fork_info")
+    {
+        return json {
+            {"version", 16},
+            {"enabled", true},
+            {"window", 10080},
+            {"votes", 10080},
+            {"threshold", 0},
+            {"voting", 16},
+            {"state", 0},
+            {"earliest_height", 2689608},
+            {"status", "OK"}};
+    }
+    else if (call == "get_fee_estimate" || call == "/get_fee_estimate")
+    {
+        return json {
+            {"fee", 20000},
+            {"quantization_mask", 10000},
+            {"fees", {20000, 80000, 320000, 4000000}},
+            {"status", "OK"}};
+    }
+    else if (call == "getblock")
+    {
+        // there is no block to return, unless scripted
+        return json {{"status", "Block not found"}};
+    }
+    else if (call == "/getheight")
+    {
+        return json {{"height", height}, {"status", "OK"}};
+    }
+    else if (call == "/get_transaction_pool")
+    {
+        return json {
+            {"transactions", json::array()},
+            {"spent_key_images", json::array()},
+            {"status", "OK"}};
+    }
+    else if (call == "/sendrawtransaction")
+    {
+        return json {
+            {"status", "OK"},
+            {"reason", ""},
+            {"not_relayed", false}};
+    }
+    else if (call == "/get_alt_blocks_hashes")
+    {
+        return json {{"blks_hashes", json::array()}, {"status", "OK"}};
+    }
+
+    return json {};
+}
+
+crow::response
+mock_daemon::handle(crow::request const& req)
+{
+    string call = req.url;
+
+    bool is_json_rpc = (call == "/json_rpc");
+
+    json rpc_id = 0;
+
+    if (is_json_rpc)
+    {
+        try
+        {
+            json rpc_req = json::parse(req.body);
+
+            call   = rpc_req.value("method", string {});
+            rpc_id = rpc_req.value("id", json(0));
+        }
+        catch (json::exception const&)
+        {
+            return crow::response(400, "Cant parse json-rpc request");
+        }
+    }
+
+    json step = json::object();
+
+    uint64_t delay_ms;
+    bool inject_error;
+
+    {
+        lock_guard<mutex> lck (mock_mutx);
+
+        call_script& cs = calls[call];
+
+        ++cs.no_of_calls;
+
+        if (!cs.steps.empty())
+        {
+            step = cs.steps[cs.next_step];
+            cs.next_step = (cs.next_step + 1) % cs.steps.size();
+        }
+
+        uint64_t step_latency = step.value("latency_ms", latency_ms);
+        uint64_t jitter       = step.value("latency_jitter_ms", latency_jitter_ms);
+
+        delay_ms = step_latency;
+
+        if (jitter > 0)
+        {
+            uniform_int_distribution<int64_t> jitter_dist (
+                    -static_cast<int64_t>(jitter), jitter);
+
+            delay_ms = static_cast<uint64_t>(std::max<int64_t>(
+                    0, static_cast<int64_t>(step_latency) + jitter_dist(rng)));
+        }
+
+        bernoulli_distribution error_dist (step.value("error_rate", error_rate));
+
+        inject_error = error_dist(rng);
+    }
+
+    string error = step.value("error", string {});
+
+    if (error.empty() && inject_error)
+        error = "http_500";
+
+    if (error == "timeout")
+        delay_ms = hang_ms;
+
+    if (delay_ms > 0)
+        this_thread::sleep_for(chrono::milliseconds {delay_ms});
+
+    if (error == "http_500" || error == "timeout")
+        return crow::response(500, "Injected error");
+
+    if (error == "malformed")
+        return crow::response(200, "application/json", "{\"status\": ");
+
+    json response = step.count("response")
+                    ? step["response"]
+                    : default_response(call);
+
+    if (response.is_null())
+        return crow::response(404);
+
+    if (error == "busy")
+        response["status"] = "BUSY";
+
+    if (is_json_rpc)
+    {
+        response = json {
+            {"jsonrpc", "2.0"},
+            {"id", rpc_id},
+            {"result", response}};
+    }
+
+    return crow::response(200, "application/json", response.dump());
+}
+
+json
+mock_daemon::stats()
+{
+    lock_guard<mutex> lck (mock_mutx);
+
+    json j_stats = json::object();
+
+    for (auto const& call: calls)
+        j_stats[call.first] = call.second.no_of_calls;
+
+    return j_stats;
+}
+
+}
+
+int
+main(int ac, const char* av[])
+{
+    uint16_t port {28081};
+    uint64_t threads {16};
+
+    mock_daemon daemon;
+
+    try
+    {
+        if (ac > 1)
+            port = boost::lexical_cast<uint16_t>(av[1]);
+
+        if (ac > 2 && string {av[2]} != "-")
+            if (!daemon.load_script(av[2]))
+                return EXIT_FAILURE;
+
+        // command line overrides defaults from the script,
+        // but not values of individual calls
+        if (ac > 3)
+            daemon.latency_ms = boost::lexical_cast<uint64_t>(av[3]);
+
+        if (ac > 4)
+            daemon.error_rate = boost::lexical_cast<double>(av[4]);
+
+        if (ac > 5)
+            threads = boost::lexical_cast<uint64_t>(av[5]);
+    }
+    catch (boost::bad_lexical_cast const& e)
+    {
+        cerr << "usage: " << av[0]
+             << " [port] [script.json] [latency_ms] [error_rate] [threads]"
+             << endl;
+        return EXIT_FAILURE;
+    }
+
+    crow::SimpleApp app;
+
+    app.loglevel(crow::LogLevel::Warning);
+
+    CROW_ROUTE(app, "/mock/stats")
+    ([&]() {
+        return crow::response(200, "application/json",
+                              daemon.stats().dump());
+    });
+
+    // routes must be registered, as crow does not read
+    // bodies of requests which go to its catchall route
+    set<string> paths {"/json_rpc",
+                       "/getheight",
+                       "/get_fee_estimate",
+                       "/get_transaction_pool",
+                       "/sendrawtransaction",
+                       "/get_alt_blocks_hashes"};
+
+    for (auto const& call: daemon.calls)
+        if (!call.first.empty() && call.first[0] == '/')
+            paths.insert(call.first);
+
+    for (string const& path: paths)
+    {
+        app.route_dynamic(path).methods("GET"_method, "POST"_method)
+        ([&](crow::request const& req) {
+            return daemon.handle(req);
+        });
+    }
+
+    cout << "Mock daemon listening on 127.0.0.1:" << port
+         << ", latency " << daemon.latency_ms << " ms"
+         << ", error rate " << daemon.error_rate << endl;
+
+    // calls sleep for their latency, so we need
+    // enough threads to have them concurrently
+    app.bindaddr("127.0.0.1").port(port)
+            .concurrency(std::max<uint64_t>(threads, 1)).run();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+//
+// Created on 18/10/26.
+//
+// Sends block/tx events to the explorer's notification socket
+// (xmrblocks --notify-socket <path>).
+//
+// It can be used by monerod, e.g.,
+//
+//   monerod --block-notify '/path/to/xmrblocks-notify /tmp/xmrblocks.sock block %s'
+//
+// or as a local stand-in for the daemon, which publishes
+// events in a loop, e.g., every 2 seconds, 100 times:
+//
+//   xmrblocks-notify /tmp/xmrblocks.sock tx - 100 2000
+//
+// usage: xmrblocks-notify <socket_path> [block|tx] [hash] [repeat] [interval_ms]
+//
+
+#include <boost/asio.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+namespace local = boost::asio::local;
+
+int
+main(int ac, const char* av[])
+{
+    if (ac < 2)
+    {
+        cerr << "usage: " << av[0]
+             << " <socket_path> [block|tx] [hash] [repeat] [interval_ms]"
+             << endl;
+        return EXIT_FAILURE;
+    }
+
+    string socket_path {av[1]};
+    string event       {ac > 2 ? av[2] : "block"};
+    string hash        {ac > 3 ? av[3] : "-"};
+
+    uint64_t repeat      {1};
+    uint64_t interval_ms {1000};
+
+    try
+    {
+        if (ac > 4)
+            repeat = boost::lexical_cast<uint64_t>(av[4]);
+
+        if (ac > 5)
+            interval_ms = boost::lexical_cast<uint64_t>(av[5]);
+    }
+    catch (boost::bad_lexical_cast const& e)
+    {
+        cerr << "repeat and interval_ms must be numbers" << endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::asio::io_context io;
+
+    local::datagram_protocol::socket socket {io};
+
+    boost::system::error_code ec;
+
+    socket.open(local::datagram_protocol(), ec);
+
+    if (ec)
+    {
+        cerr << "Cant open socket: " << ec.message() << endl;
+        return EXIT_FAILURE;
+    }
+
+    local::datagram_protocol::endpoint explorer {socket_path};
+
+    // the explorer only cares that something happened,
+    // the content is just for debugging.
+    string message = event + " " + hash;
+
+    for (uint64_t i = 0; i < repeat; ++i)
+    {
+        if (i > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+
+        socket.send_to(boost::asio::buffer(message), explorer, 0, ec);
+
+        if (ec)
+        {
+            // explorer may be not running yet, or restarting
+            cerr << "Cant send to " << socket_path
+                 << ": " << ec.message() << endl;
+            continue;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}